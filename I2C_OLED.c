@@ -6,11 +6,10 @@
 #include <stdbool.h>
 #include <string.h>
 
-#include "stm32f1xx_hal.h"
-
-#include "i2c.h"
+#include I2C_OLED_HAL_HEADER
 
 #include "Font_VertHorz.h"
+#include "I2C_OLED_Trace.h"
 
 I2C_HandleTypeDef *I2C_OLED_i2c_handler = NULL;
 
@@ -22,6 +21,28 @@ bool I2C_OLED_non_overwrite_direct = false;
 
 uint8_t I2C_OLED_buffer[I2C_OLED_BUFFER_SIZE];
 
+I2C_OLED_Rotation I2C_OLED_rotation = I2C_OLED_ROTATION_0;
+
+// Size of the image in the buffer, swapped for 90/270 //
+uint8_t I2C_OLED_logical_columns = I2C_OLED_COLUMNS;
+uint8_t I2C_OLED_logical_pages = I2C_OLED_PAGES;
+uint8_t I2C_OLED_logical_rows = I2C_OLED_ROWS;
+
+// Area drawn while manual update was on //
+I2C_OLED_Rect I2C_OLED_dirty = { 0, 0, -1, -1 };
+
+bool I2C_OLED_double_buffer = false;
+
+// Double buffering: GDDRAM page the buffer goes to, and what the hidden half is missing //
+static uint8_t ram_page_offset = 0;
+static I2C_OLED_Rect back_stale = { 0, 0, -1, -1 };
+
+#if I2C_OLED_PANEL_ROWS == 32
+#define I2C_OLED_COM_PINS_CONFIGURATION 0x02    // Sequential, no left/right remap
+#else
+#define I2C_OLED_COM_PINS_CONFIGURATION 0x12    // Alternative, no left/right remap
+#endif
+
 /*
     Reference:
         https://cdn-shop.adafruit.com/datasheets/UG-2864HSWEG01.pdf
@@ -32,32 +53,66 @@ static const uint8_t ssd1306_initialization_sequence[] =
     0xAE,       // Set display off
     
     0xD5, 0x80, // Set display clock divide ration oscillator frequency
-    0xA8, 0x3F, // Set multiplex ratio
+    0xA8, I2C_OLED_ROWS - 1, // Set multiplex ratio
     0xD3, 0x00, // Set display offset
     0x40,       // Set display start line
     0x8D, 0x14, // Set charge pump          (2nd byte: 0x10 external VCC, 0x14 internal DC/DC)
-    0xA1,       // Set segment re-map
-    0xC8,       // Set COM output scan direction
-    0xDA, 0x12, // Set COM pins hardware configuration
+    0xDA, I2C_OLED_COM_PINS_CONFIGURATION, // Set COM pins hardware configuration
     0x81, 0xCF, // Set contrast control     (2nd byte: 0x9F external VCC, 0xCF internal DC/DC)
     0xD9, 0xF1, // Set pre-charge period    (2nd byte: 0x22 external VCC, 0xF1 internal DC/DC)
     0xDB, 0x40, // Set VCOMH deselect level
     0xA4,       // Set entire display on
     0xA6,       // Set normal display
+    0x20, 0x02, // Set memory addressing mode (to page mode)
     
-    0xAF,       // Set display on
+    // Segment re-map and COM output scan direction follow, then display on //
 };
 
-static const uint8_t ssd1306_addressing_mode_configuration_sequence[] =
+/*
+    0xA1/0xC8 is the upright orientation.
+    180 flips both, 90/270 transpose the buffer on flush and flip one axis.
+*/
+static const uint8_t remap_commands[][2] =
 {
-    0x20, 0x10, // Set memory addressing mode (to horizontal mode)
+    { 0xA1, 0xC8 }, // 0
+    { 0xA0, 0xC8 }, // 90  (transposed)
+    { 0xA0, 0xC0 }, // 180
+    { 0xA1, 0xC0 }, // 270 (transposed)
 };
 
+static void I2C_OLED_SendRemapCommands(void)
+{
+    if (I2C_OLED_i2c_handler == NULL)
+        return;
+    
+    I2C_OLED_TRACE_WRITE(0x00, remap_commands[I2C_OLED_rotation], sizeof(remap_commands[0]));
+    
+    HAL_I2C_Mem_Write
+    (
+        I2C_OLED_i2c_handler,
+        I2C_OLED_ADDR,
+        0x00,
+        1,
+        (uint8_t *)remap_commands[I2C_OLED_rotation],
+        sizeof(remap_commands[0]),
+        I2C_OLED_TIMEOUT
+    );
+}
+
 void I2C_OLED_Initialize(I2C_HandleTypeDef *i2c_handler)
 {
     I2C_OLED_i2c_handler = i2c_handler;
     
-    // Initialization sequence //
+    // Initialization, addressing mode and orientation in one transfer //
+    
+    uint8_t sequence[sizeof(ssd1306_initialization_sequence) + sizeof(remap_commands[0]) + 1];
+    
+    memcpy(sequence, ssd1306_initialization_sequence, sizeof(ssd1306_initialization_sequence));
+    memcpy(sequence + sizeof(ssd1306_initialization_sequence), remap_commands[I2C_OLED_rotation], sizeof(remap_commands[0]));
+    
+    sequence[sizeof(sequence) - 1] = 0xAF;  // Set display on
+    
+    I2C_OLED_TRACE_WRITE(0x00, sequence, sizeof(sequence));
     
     HAL_I2C_Mem_Write
     (
@@ -65,28 +120,175 @@ void I2C_OLED_Initialize(I2C_HandleTypeDef *i2c_handler)
         I2C_OLED_ADDR,
         0x00,
         1,
-        (uint8_t *)ssd1306_initialization_sequence,
-        sizeof(ssd1306_initialization_sequence),
-        100
+        sequence,
+        sizeof(sequence),
+        I2C_OLED_TIMEOUT
     );
+    
+    // Start line was reset to 0 //
+    
+    if (I2C_OLED_double_buffer)
+        I2C_OLED_SetDoubleBuffer(true);
+}
+
+/*
+    Sleep keeps GDDRAM and every setting as long as VDD stays on, only the
+    panel and its charge pump are switched off (datasheet: charge pump off
+    after display off, display on after charge pump on).
+*/
+void I2C_OLED_Sleep(void)
+{
+    static const uint8_t sleep_commands[] =
+    {
+        0xAE,       // Set display off
+        0x8D, 0x10, // Set charge pump off
+    };
+    
+    if (I2C_OLED_i2c_handler == NULL)
+        return;
+    
+    I2C_OLED_TRACE_WRITE(0x00, sleep_commands, sizeof(sleep_commands));
+    
+    HAL_I2C_Mem_Write
+    (
+        I2C_OLED_i2c_handler,
+        I2C_OLED_ADDR,
+        0x00,
+        1,
+        (uint8_t *)sleep_commands,
+        sizeof(sleep_commands),
+        I2C_OLED_TIMEOUT
+    );
+}
+
+void I2C_OLED_Resume(bool ram_retained)
+{
+    static const uint8_t resume_commands[] =
+    {
+        0x8D, 0x14, // Set charge pump on
+        0xAF,       // Set display on
+    };
+    
+    if (I2C_OLED_i2c_handler == NULL)
+        return;
+    
+    if (!ram_retained)
+    {
+        // Controller lost power: full initialization, then the frame is sent again //
         
-    // Addressing mode //
-        
+        I2C_OLED_Initialize(I2C_OLED_i2c_handler);
+        I2C_OLED_Update();
+        return;
+    }
+    
+    I2C_OLED_TRACE_WRITE(0x00, resume_commands, sizeof(resume_commands));
+    
     HAL_I2C_Mem_Write
     (
         I2C_OLED_i2c_handler,
         I2C_OLED_ADDR,
         0x00,
         1,
-        (uint8_t *)ssd1306_addressing_mode_configuration_sequence,
-        sizeof(ssd1306_addressing_mode_configuration_sequence),
-        100
+        (uint8_t *)resume_commands,
+        sizeof(resume_commands),
+        I2C_OLED_TIMEOUT
+    );
+}
+
+static void I2C_OLED_FitClipToScreen(void);
+
+// Buffer contents are not converted, redraw after changing between 0/180 and 90/270. //
+
+void I2C_OLED_SetRotation(I2C_OLED_Rotation rotation)
+{
+    if (rotation > I2C_OLED_ROTATION_270)
+        return;
+    
+    I2C_OLED_rotation = rotation;
+    
+    if (rotation == I2C_OLED_ROTATION_90 || rotation == I2C_OLED_ROTATION_270)
+    {
+        I2C_OLED_logical_columns = I2C_OLED_ROWS;
+        I2C_OLED_logical_rows = I2C_OLED_COLUMNS;
+    }
+    else
+    {
+        I2C_OLED_logical_columns = I2C_OLED_COLUMNS;
+        I2C_OLED_logical_rows = I2C_OLED_ROWS;
+    }
+    
+    I2C_OLED_logical_pages = I2C_OLED_logical_rows / 8;
+    
+    I2C_OLED_FitClipToScreen();
+    
+    if (I2C_OLED_cursor_column >= I2C_OLED_logical_columns)
+        I2C_OLED_cursor_column = 0;
+    if (I2C_OLED_cursor_page >= I2C_OLED_logical_pages)
+        I2C_OLED_cursor_page = 0;
+    
+    I2C_OLED_SendRemapCommands();
+}
+
+// Double buffering //
+
+static void I2C_OLED_SendStartLine(uint8_t start_line)
+{
+    uint8_t start_line_command = 0x40 | (start_line & 0x3F);
+    
+    if (I2C_OLED_i2c_handler == NULL)
+        return;
+    
+    I2C_OLED_TRACE_WRITE(0x00, &start_line_command, 1);
+    
+    HAL_I2C_Mem_Write
+    (
+        I2C_OLED_i2c_handler,
+        I2C_OLED_ADDR,
+        0x00,
+        1,
+        &start_line_command,
+        1,
+        I2C_OLED_TIMEOUT
     );
 }
 
+bool I2C_OLED_SetDoubleBuffer(bool enabled)
+{
+    if (enabled && I2C_OLED_PAGES * 2 > I2C_OLED_GDDRAM_PAGES)
+        return false;
+    
+    I2C_OLED_double_buffer = enabled;
+    
+    // Front half is 0-3, the hidden half has never been written //
+    
+    ram_page_offset = enabled ? I2C_OLED_PAGES : 0;
+    
+    back_stale.start_x = 0;
+    back_stale.start_y = 0;
+    back_stale.end_x = I2C_OLED_logical_columns - 1;
+    back_stale.end_y = I2C_OLED_logical_rows - 1;
+    
+    I2C_OLED_SendStartLine(0);
+    
+    return true;
+}
+
+/*
+    Shows the hidden half. The half that becomes hidden holds the previous
+    frame, it lacks whatever the presented frame changed (presented).
+*/
+static void I2C_OLED_Flip(const I2C_OLED_Rect *presented)
+{
+    I2C_OLED_SendStartLine(ram_page_offset * 8);
+    
+    ram_page_offset = I2C_OLED_PAGES - ram_page_offset;
+    
+    back_stale = *presented;
+}
+
 void I2C_OLED_SetColumnPage(uint8_t column, uint8_t page)
 {
-    if (column >= I2C_OLED_COLUMNS || page >= I2C_OLED_PAGES)
+    if (column >= I2C_OLED_COLUMNS || page >= I2C_OLED_GDDRAM_PAGES)
         return;
     
     uint8_t column_nibble_h = (column >> 4) & 0x0F;
@@ -99,6 +301,8 @@ void I2C_OLED_SetColumnPage(uint8_t column, uint8_t page)
         0x10 + column_nibble_h, // Column start address H nibble
     };
     
+    I2C_OLED_TRACE_WRITE(0x00, addressing_setting_sequence, sizeof(addressing_setting_sequence));
+    
     HAL_I2C_Mem_Write
     (
         I2C_OLED_i2c_handler,
@@ -116,6 +320,8 @@ void I2C_OLED_WriteToRAM(const uint8_t *buffer, uint16_t count)
     if (buffer == NULL)
         return;
     
+    I2C_OLED_TRACE_WRITE(0x40, buffer, count);
+    
     HAL_I2C_Mem_Write
     (
         I2C_OLED_i2c_handler,
@@ -126,214 +332,1502 @@ void I2C_OLED_WriteToRAM(const uint8_t *buffer, uint16_t count)
         count,
         I2C_OLED_TIMEOUT
     );
-}    
-void I2C_OLED_Update(void)
-{
-    for (int i = 0; i < I2C_OLED_PAGES; i++)
-    {
-        I2C_OLED_SetColumnPage(0, i);
-            
-        int offset = i * I2C_OLED_COLUMNS;
-            
-        I2C_OLED_WriteToRAM(I2C_OLED_buffer + offset, 128);
-    }
 }
 
-void I2C_OLED_UpdatePartially
-(
-    uint8_t start_column, uint8_t end_column,
-    uint8_t start_page,   uint8_t end_page
-)
+/*
+    Packets put several command and data segments behind one START and
+    slave address. Every segment but the last uses Co = 1 control bytes
+    (0x80 command / 0xC0 data, one byte each), the last data segment can
+    be sent as a 0x40 stream.
+*/
+
+void I2C_OLED_Packet_Begin(I2C_OLED_Packet *packet, uint8_t *buffer, uint16_t capacity)
 {
-    if (start_column > end_column)
-    {
-        int16_t temp = start_column;
-        start_column = end_column;
-        end_column = temp;
-    }
-    if (start_page > end_page)
-    {
-        int16_t temp = start_page;
-        start_page = end_page;
-        end_page = temp;
-    }
-    
-    if (start_column >= I2C_OLED_COLUMNS || start_page >= I2C_OLED_PAGES)
+    if (packet == NULL)
         return;
     
-    if (end_column >= I2C_OLED_COLUMNS)
-        end_column = I2C_OLED_COLUMNS - 1;
-    
-    if (end_page >= I2C_OLED_PAGES)
-        end_page = I2C_OLED_PAGES - 1;
-    
-    uint8_t columns_to_update_per_page = end_column - start_column + 1;
+    packet->buffer = buffer;
+    packet->capacity = capacity;
+    packet->length = 0;
+    packet->closed = false;
+    packet->overflow = buffer == NULL;
+}
+
+static bool I2C_OLED_Packet_Reserve(I2C_OLED_Packet *packet, uint16_t count)
+{
+    if (packet == NULL || packet->closed || packet->overflow)
+        return false;
     
-    for (int page = start_page; page <= end_page; page++)
+    if (packet->length + count > packet->capacity)
     {
-        I2C_OLED_SetColumnPage(start_column, page);
-        
-        int offset = (page * I2C_OLED_COLUMNS) + start_column;
-        
-        I2C_OLED_WriteToRAM(I2C_OLED_buffer + offset, columns_to_update_per_page);
+        packet->overflow = true;
+        return false;
     }
+    
+    return true;
 }
 
-void I2C_OLED_ClearDirect(void)
+bool I2C_OLED_Packet_AddCommands(I2C_OLED_Packet *packet, const uint8_t *commands, uint16_t count)
 {
-    static const uint8_t buffer_clear[8] = { 0x00 };
+    if (commands == NULL || !I2C_OLED_Packet_Reserve(packet, count * 2))
+        return false;
     
-    for (int i = 0; i < I2C_OLED_PAGES; i++)
+    uint8_t *ptr_packet = packet->buffer + packet->length;
+    
+    for (int i = 0; i < count; i++)
     {
-        I2C_OLED_SetColumnPage(0, i);
-        
-        for (int j = 0; j < I2C_OLED_COLUMNS / sizeof(buffer_clear); j++)
-            I2C_OLED_WriteToRAM(buffer_clear, sizeof(buffer_clear));
+        *ptr_packet++ = I2C_OLED_CONTROL_COMMAND;
+        *ptr_packet++ = commands[i];
     }
+    
+    packet->length += count * 2;
+    
+    return true;
 }
 
-void I2C_OLED_ClearBuffer(void)
+bool I2C_OLED_Packet_AddColumnPage(I2C_OLED_Packet *packet, uint8_t column, uint8_t page)
 {
-    uint8_t *ptr_buffer = I2C_OLED_buffer;
+    if (column >= I2C_OLED_COLUMNS || page >= I2C_OLED_GDDRAM_PAGES)
+        return false;
     
-    for (int i = 0; i < sizeof(I2C_OLED_buffer); i++)
+    uint8_t addressing_setting_sequence[] =
     {
-        *ptr_buffer = 0x00;
-        ptr_buffer++;
-    }
+        0xB0 + page,                    // Page start address
+        0x00 + (column & 0x0F),         // Column start address L nibble
+        0x10 + ((column >> 4) & 0x0F),  // Column start address H nibble
+    };
     
-    if (!I2C_OLED_manual_update)
-        I2C_OLED_Update();
+    return I2C_OLED_Packet_AddCommands(packet, addressing_setting_sequence, sizeof(addressing_setting_sequence));
 }
 
-void I2C_OLED_ClearBufferAndUpdate(void)
+bool I2C_OLED_Packet_AddData(I2C_OLED_Packet *packet, const uint8_t *data, uint16_t count)
 {
-    I2C_OLED_ClearBuffer();
+    if (data == NULL || !I2C_OLED_Packet_Reserve(packet, count * 2))
+        return false;
     
-    if (I2C_OLED_manual_update)
-        I2C_OLED_Update();
+    uint8_t *ptr_packet = packet->buffer + packet->length;
+    
+    for (int i = 0; i < count; i++)
+    {
+        *ptr_packet++ = I2C_OLED_CONTROL_DATA;
+        *ptr_packet++ = data[i];
+    }
+    
+    packet->length += count * 2;
+    
+    return true;
 }
 
-void I2C_OLED_SetCursor(uint8_t column, uint8_t page)
+bool I2C_OLED_Packet_AddDataStream(I2C_OLED_Packet *packet, const uint8_t *data, uint16_t count)
 {
-    if (column >= I2C_OLED_COLUMNS)
-        column = I2C_OLED_COLUMNS - 1;
+    if (data == NULL || !I2C_OLED_Packet_Reserve(packet, count + 1))
+        return false;
     
-    if (page >= I2C_OLED_PAGES)
-        page = I2C_OLED_PAGES - 1;
+    uint8_t *ptr_packet = packet->buffer + packet->length;
     
-    I2C_OLED_cursor_column = column;
-    I2C_OLED_cursor_page = page;
+    *ptr_packet++ = I2C_OLED_CONTROL_DATA_STREAM;
+    memcpy(ptr_packet, data, count);
+    
+    packet->length += count + 1;
+    packet->closed = true;
+    
+    return true;
 }
 
-void I2C_OLED_PutCharDirect(char character, bool inverted)
+void I2C_OLED_Packet_Send(I2C_OLED_Packet *packet)
 {
-    if (character < 0x20 || character > 0x7F)
-        character = 0x20;
+    if (packet == NULL || packet->overflow || packet->length == 0)
+        return;
     
-    int index_of_glyph = character - 0x20;
+    I2C_OLED_TRACE_WRITE(packet->buffer[0], packet->buffer + 1, packet->length - 1);
     
-    if (!inverted)
-    {
-        uint8_t empty_byte = 0x00;
-        
-        I2C_OLED_WriteToRAM(Font_VertHorz_ascii[index_of_glyph], 5);
-        I2C_OLED_WriteToRAM(&empty_byte, 1);
-    }
-    else
-    {
-        uint8_t glyph_buffer[6];
-        
-        uint8_t *ptr_glyph_source = (uint8_t *)Font_VertHorz_ascii[index_of_glyph];
-        uint8_t *ptr_glyph_buffer = glyph_buffer;
-        
-        for (int i = 0; i < 5; i++)
-        {
-            *ptr_glyph_buffer = ~(*ptr_glyph_source);
-            
-            ptr_glyph_buffer++;
-            ptr_glyph_source++;
-        }
-        
-        glyph_buffer[5] = 0x00;
-        
-        I2C_OLED_WriteToRAM(glyph_buffer, 6);
-    }
+    HAL_I2C_Master_Transmit
+    (
+        I2C_OLED_i2c_handler,
+        I2C_OLED_ADDR,
+        packet->buffer,
+        packet->length,
+        I2C_OLED_TIMEOUT
+    );
 }
 
-void I2C_OLED_PrintStrDirect(const char *str, bool inverted)
+// Address setup and data in one transfer instead of SetColumnPage + WriteToRAM //
+
+void I2C_OLED_WriteToRAMAt(uint8_t column, uint8_t page, const uint8_t *buffer, uint16_t count)
 {
-    if (str == NULL)
+    static uint8_t packet_buffer[I2C_OLED_PACKET_HEADER_SIZE + I2C_OLED_COLUMNS];
+    
+    if (buffer == NULL)
         return;
     
-    while (*str)
+    if (count > I2C_OLED_COLUMNS)
     {
-        I2C_OLED_PutCharDirect(*str, inverted);
-        str++;
+        I2C_OLED_SetColumnPage(column, page);
+        I2C_OLED_WriteToRAM(buffer, count);
+        return;
     }
+    
+    I2C_OLED_Packet packet;
+    
+    I2C_OLED_Packet_Begin(&packet, packet_buffer, sizeof(packet_buffer));
+    
+    if (!I2C_OLED_Packet_AddColumnPage(&packet, column, page))
+        return;
+    
+    I2C_OLED_Packet_AddDataStream(&packet, buffer, count);
+    I2C_OLED_Packet_Send(&packet);
 }
 
-void I2C_OLED_PutChar(char character, bool inverted)
+/*
+    8x8 bit-matrix transpose: bit j of source byte i becomes bit i of
+    destination byte j. Three rounds of delta swaps on a 64-bit word.
+*/
+static void I2C_OLED_Transpose8x8(const uint8_t *source, uint8_t *destination)
 {
-    if (character < 0x20 || character > 0x7F)
-        character = 0x20;
+    uint64_t x = 0;
     
-    uint8_t start_column = I2C_OLED_cursor_column;
+    for (int i = 7; i >= 0; i--)
+        x = (x << 8) | source[i];
     
-    int index_of_glyph = character - 0x20;
+    uint64_t t;
     
-    uint8_t *ptr_buffer = &I2C_OLED_buffer[(I2C_OLED_cursor_page * I2C_OLED_COLUMNS) + I2C_OLED_cursor_column];
-    uint8_t *ptr_font = (uint8_t *)Font_VertHorz_ascii[index_of_glyph];
+    t = 0x0F0F0F0F00000000ULL & (x ^ (x << 28));
+    x ^= t ^ (t >> 28);
+    t = 0x3333000033330000ULL & (x ^ (x << 14));
+    x ^= t ^ (t >> 14);
+    t = 0x5500550055005500ULL & (x ^ (x << 7));
+    x ^= t ^ (t >> 7);
     
-    for (int i = 0; i < 5; i++)
+    for (int i = 0; i < 8; i++)
     {
-        if (!inverted)
-            *ptr_buffer |= *ptr_font;
-        else
-            *ptr_buffer &= ~(*ptr_font);
-        
-        if (I2C_OLED_cursor_column >= I2C_OLED_COLUMNS - 1)
-            break;
-        
-        I2C_OLED_cursor_column++;
-        
-        ptr_buffer++;
-        ptr_font++;
+        destination[i] = (uint8_t)x;
+        x >>= 8;
     }
-    
-    I2C_OLED_cursor_column++;
-    
-    if (!I2C_OLED_manual_update)
-        I2C_OLED_UpdatePartially(start_column, I2C_OLED_cursor_column, I2C_OLED_cursor_page, I2C_OLED_cursor_page);
 }
 
-void I2C_OLED_PrintStr(const char *str, bool inverted)
+/*
+    90/270: the buffer holds a 64x128 logical image. Logical pages map to
+    physical column groups of 8 and logical column groups of 8 map to
+    physical pages, each 8x8 block is transposed on the way out.
+*/
+static uint8_t rotated_page_buffer[I2C_OLED_COLUMNS];
+
+// Fills rotated_page_buffer for one physical page, logical pages start_page to end_page //
+
+static void I2C_OLED_TransposePage(uint8_t physical_page, uint8_t start_page, uint8_t end_page)
 {
-    if (str == NULL)
-        return;
+    const uint8_t *ptr_source = I2C_OLED_buffer + (start_page * I2C_OLED_logical_columns) + (physical_page * 8);
+    uint8_t *ptr_destination = rotated_page_buffer + (start_page * 8);
     
-    while (*str)
+    for (int page = start_page; page <= end_page; page++)
     {
-        I2C_OLED_PutChar(*str, inverted);
-        str++;
+        I2C_OLED_Transpose8x8(ptr_source, ptr_destination);
+        
+        ptr_source += I2C_OLED_logical_columns;
+        ptr_destination += 8;
     }
 }
 
-// Out of bounds shapes are allowed. //
-
-void I2C_OLED_DrawRect
+static void I2C_OLED_UpdateRotated
 (
-    int16_t start_x, int16_t start_y,
-    int16_t end_x, int16_t end_y,
-    bool inverted
+    uint8_t start_column, uint8_t end_column,
+    uint8_t start_page,   uint8_t end_page
 )
 {
-    // start_x/y can be smaller than end_x/y //
+    uint8_t physical_start_column = start_page * 8;
+    uint8_t physical_columns = (end_page - start_page + 1) * 8;
     
-    if (start_x > end_x)
+    for (int physical_page = start_column / 8; physical_page <= end_column / 8; physical_page++)
     {
-        int16_t temp = start_x;
-        start_x = end_x;
+        I2C_OLED_TransposePage(physical_page, start_page, end_page);
+        
+        I2C_OLED_WriteToRAMAt(physical_start_column, physical_page + ram_page_offset, rotated_page_buffer + physical_start_column, physical_columns);
+    }
+}
+
+void I2C_OLED_Update(void)
+{
+    // Everything is sent, nothing stays dirty //
+    
+    I2C_OLED_dirty.start_x = 0;
+    I2C_OLED_dirty.start_y = 0;
+    I2C_OLED_dirty.end_x = -1;
+    I2C_OLED_dirty.end_y = -1;
+    
+    if (I2C_OLED_rotation == I2C_OLED_ROTATION_90 || I2C_OLED_rotation == I2C_OLED_ROTATION_270)
+    {
+        I2C_OLED_UpdateRotated(0, I2C_OLED_logical_columns - 1, 0, I2C_OLED_logical_pages - 1);
+    }
+    else
+    {
+        for (int i = 0; i < I2C_OLED_PAGES; i++)
+        {
+            int offset = i * I2C_OLED_COLUMNS;
+            
+            I2C_OLED_WriteToRAMAt(0, i + ram_page_offset, I2C_OLED_buffer + offset, I2C_OLED_COLUMNS);
+        }
+    }
+    
+    if (I2C_OLED_double_buffer)
+    {
+        // What changed since the previous frame is unknown //
+        
+        I2C_OLED_Rect presented = { 0, 0, I2C_OLED_logical_columns - 1, I2C_OLED_logical_rows - 1 };
+        
+        I2C_OLED_Flip(&presented);
+    }
+}
+
+void I2C_OLED_UpdatePartially
+(
+    uint8_t start_column, uint8_t end_column,
+    uint8_t start_page,   uint8_t end_page
+)
+{
+    if (start_column > end_column)
+    {
+        int16_t temp = start_column;
+        start_column = end_column;
+        end_column = temp;
+    }
+    if (start_page > end_page)
+    {
+        int16_t temp = start_page;
+        start_page = end_page;
+        end_page = temp;
+    }
+    
+    // Columns and pages are logical //
+    
+    if (start_column >= I2C_OLED_logical_columns || start_page >= I2C_OLED_logical_pages)
+        return;
+    
+    if (end_column >= I2C_OLED_logical_columns)
+        end_column = I2C_OLED_logical_columns - 1;
+    
+    if (end_page >= I2C_OLED_logical_pages)
+        end_page = I2C_OLED_logical_pages - 1;
+    
+    if (I2C_OLED_rotation == I2C_OLED_ROTATION_90 || I2C_OLED_rotation == I2C_OLED_ROTATION_270)
+    {
+        I2C_OLED_UpdateRotated(start_column, end_column, start_page, end_page);
+        return;
+    }
+    
+    uint8_t columns_to_update_per_page = end_column - start_column + 1;
+    
+    for (int page = start_page; page <= end_page; page++)
+    {
+        int offset = (page * I2C_OLED_COLUMNS) + start_column;
+        
+        I2C_OLED_WriteToRAMAt(start_column, page + ram_page_offset, I2C_OLED_buffer + offset, columns_to_update_per_page);
+    }
+}
+
+/*
+    Time-sliced flush: the region is sent in chunks of whole or partial
+    pages, each chunk being one transfer with its own address setup.
+    A step never sends more than the given budget, so the caller can bound
+    how long one call blocks (about 40 bytes per ms at 400 kHz). With double
+    buffering the flip is part of the flush: it goes out in the step that
+    sends the last chunk if the budget has room left, otherwise in the next.
+*/
+
+static bool flush_active = false;
+static bool flush_flip_pending = false;
+
+// Physical region and position //
+static uint8_t flush_start_column, flush_end_column;
+static uint8_t flush_start_page, flush_end_page;
+static uint8_t flush_column, flush_page;
+
+static uint16_t flush_sent = 0;
+static uint16_t flush_total = 0;
+
+// Double buffering: logical area the caller asked for, shown when the flush is done //
+static I2C_OLED_Rect flush_presented;
+
+void I2C_OLED_FlushBeginPartially
+(
+    uint8_t start_column, uint8_t end_column,
+    uint8_t start_page,   uint8_t end_page
+)
+{
+    if (start_column > end_column)
+    {
+        uint8_t temp = start_column;
+        start_column = end_column;
+        end_column = temp;
+    }
+    if (start_page > end_page)
+    {
+        uint8_t temp = start_page;
+        start_page = end_page;
+        end_page = temp;
+    }
+    
+    // Columns and pages are logical //
+    
+    if (start_column >= I2C_OLED_logical_columns || start_page >= I2C_OLED_logical_pages)
+        return;
+    
+    if (end_column >= I2C_OLED_logical_columns)
+        end_column = I2C_OLED_logical_columns - 1;
+    
+    if (end_page >= I2C_OLED_logical_pages)
+        end_page = I2C_OLED_logical_pages - 1;
+    
+    if (I2C_OLED_double_buffer)
+    {
+        flush_presented.start_x = start_column;
+        flush_presented.start_y = start_page * 8;
+        flush_presented.end_x = end_column;
+        flush_presented.end_y = (end_page * 8) + 7;
+        
+        // The hidden half has to catch up with the previous frame as well //
+        
+        if (back_stale.start_x <= back_stale.end_x)
+        {
+            if (back_stale.start_x < start_column)
+                start_column = back_stale.start_x;
+            if (back_stale.end_x > end_column)
+                end_column = back_stale.end_x;
+            if (back_stale.start_y / 8 < start_page)
+                start_page = back_stale.start_y / 8;
+            if (back_stale.end_y / 8 > end_page)
+                end_page = back_stale.end_y / 8;
+        }
+    }
+    
+    if (I2C_OLED_rotation == I2C_OLED_ROTATION_90 || I2C_OLED_rotation == I2C_OLED_ROTATION_270)
+    {
+        flush_start_column = start_page * 8;
+        flush_end_column = (end_page * 8) + 7;
+        flush_start_page = start_column / 8;
+        flush_end_page = end_column / 8;
+    }
+    else
+    {
+        flush_start_column = start_column;
+        flush_end_column = end_column;
+        flush_start_page = start_page;
+        flush_end_page = end_page;
+    }
+    
+    flush_total = (flush_end_column - flush_start_column + 1) * (flush_end_page - flush_start_page + 1);
+    
+    I2C_OLED_FlushRestart();
+}
+
+void I2C_OLED_FlushBegin(void)
+{
+    I2C_OLED_FlushBeginPartially(0, I2C_OLED_logical_columns - 1, 0, I2C_OLED_logical_pages - 1);
+}
+
+// Buffer changed while a flush was running: start the same region over //
+
+void I2C_OLED_FlushRestart(void)
+{
+    if (flush_total == 0)
+        return;
+    
+    flush_column = flush_start_column;
+    flush_page = flush_start_page;
+    flush_sent = 0;
+    
+    flush_flip_pending = false;
+    flush_active = true;
+}
+
+bool I2C_OLED_FlushStep(uint16_t byte_budget)
+{
+    // Slave address + address setup + data control byte per chunk //
+    
+    const uint16_t chunk_overhead = 1 + I2C_OLED_PACKET_HEADER_SIZE;
+    
+    while (flush_active)
+    {
+        if (flush_flip_pending)
+        {
+            if (byte_budget < I2C_OLED_FLUSH_FLIP_BYTES)
+                break;
+            
+            I2C_OLED_Flip(&flush_presented);
+            
+            flush_flip_pending = false;
+            flush_active = false;
+            break;
+        }
+        
+        if (byte_budget <= chunk_overhead)
+            break;
+        
+        uint16_t count = byte_budget - chunk_overhead;
+        
+        if (count > flush_end_column - flush_column + 1)
+            count = flush_end_column - flush_column + 1;
+        
+        const uint8_t *ptr_data;
+        
+        if (I2C_OLED_rotation == I2C_OLED_ROTATION_90 || I2C_OLED_rotation == I2C_OLED_ROTATION_270)
+        {
+            I2C_OLED_TransposePage(flush_page, flush_column / 8, (flush_column + count - 1) / 8);
+            ptr_data = rotated_page_buffer + flush_column;
+        }
+        else
+        {
+            ptr_data = I2C_OLED_buffer + (flush_page * I2C_OLED_COLUMNS) + flush_column;
+        }
+        
+        I2C_OLED_WriteToRAMAt(flush_column, flush_page + ram_page_offset, ptr_data, count);
+        
+        byte_budget -= chunk_overhead + count;
+        flush_sent += count;
+        flush_column += count;
+        
+        if (flush_column > flush_end_column)
+        {
+            flush_column = flush_start_column;
+            flush_page++;
+            
+            if (flush_page > flush_end_page)
+            {
+                if (I2C_OLED_double_buffer)
+                    flush_flip_pending = true;
+                else
+                    flush_active = false;
+            }
+        }
+    }
+    
+    return !flush_active;
+}
+
+bool I2C_OLED_FlushBusy(void)
+{
+    return flush_active;
+}
+
+void I2C_OLED_FlushGetProgress(uint16_t *out_sent, uint16_t *out_total)
+{
+    if (out_sent != NULL)
+        *out_sent = flush_sent;
+    
+    if (out_total != NULL)
+        *out_total = flush_total;
+}
+
+/*
+    Whole GDDRAM (both halves on 128x32) in one data burst: horizontal
+    addressing over the full window, then back to page addressing.
+*/
+void I2C_OLED_ClearDirect(void)
+{
+    static const uint8_t gddram_clear[I2C_OLED_COLUMNS * I2C_OLED_GDDRAM_PAGES] = { 0x00 };
+    
+    static const uint8_t horizontal_mode_commands[] =
+    {
+        0x20, 0x00,                                 // Set memory addressing mode (to horizontal mode)
+        0x21, 0x00, I2C_OLED_COLUMNS - 1,           // Set column address
+        0x22, 0x00, I2C_OLED_GDDRAM_PAGES - 1,      // Set page address
+    };
+    
+    static const uint8_t page_mode_commands[] =
+    {
+        0x20, 0x02,                                 // Set memory addressing mode (to page mode)
+    };
+    
+    I2C_OLED_TRACE_WRITE(0x00, horizontal_mode_commands, sizeof(horizontal_mode_commands));
+    
+    HAL_I2C_Mem_Write
+    (
+        I2C_OLED_i2c_handler,
+        I2C_OLED_ADDR,
+        0x00,
+        1,
+        (uint8_t *)horizontal_mode_commands,
+        sizeof(horizontal_mode_commands),
+        I2C_OLED_TIMEOUT
+    );
+    
+    I2C_OLED_TRACE_WRITE(0x40, gddram_clear, sizeof(gddram_clear));
+    
+    HAL_I2C_Mem_Write
+    (
+        I2C_OLED_i2c_handler,
+        I2C_OLED_ADDR,
+        0x40,
+        1,
+        (uint8_t *)gddram_clear,
+        sizeof(gddram_clear),
+        I2C_OLED_TIMEOUT * 3     // About 95 ms at 100 kHz
+    );
+    
+    I2C_OLED_TRACE_WRITE(0x00, page_mode_commands, sizeof(page_mode_commands));
+    
+    HAL_I2C_Mem_Write
+    (
+        I2C_OLED_i2c_handler,
+        I2C_OLED_ADDR,
+        0x00,
+        1,
+        (uint8_t *)page_mode_commands,
+        sizeof(page_mode_commands),
+        I2C_OLED_TIMEOUT
+    );
+}
+
+void I2C_OLED_ClearBuffer(void)
+{
+    uint8_t *ptr_buffer = I2C_OLED_buffer;
+    
+    for (size_t i = 0; i < sizeof(I2C_OLED_buffer); i++)
+    {
+        *ptr_buffer = 0x00;
+        ptr_buffer++;
+    }
+    
+    I2C_OLED_MarkDirty(0, 0, I2C_OLED_logical_columns - 1, I2C_OLED_logical_rows - 1);
+}
+
+void I2C_OLED_ClearBufferAndUpdate(void)
+{
+    I2C_OLED_ClearBuffer();
+    
+    if (I2C_OLED_manual_update || I2C_OLED_double_buffer)
+        I2C_OLED_Update();
+}
+
+void I2C_OLED_SetCursor(uint8_t column, uint8_t page)
+{
+    if (column >= I2C_OLED_logical_columns)
+        column = I2C_OLED_logical_columns - 1;
+    
+    if (page >= I2C_OLED_logical_pages)
+        page = I2C_OLED_logical_pages - 1;
+    
+    I2C_OLED_cursor_column = column;
+    I2C_OLED_cursor_page = page;
+}
+
+// Clip rectangle //
+
+I2C_OLED_ClipRect I2C_OLED_clip =
+{
+    0, 0,
+    I2C_OLED_COLUMNS - 1, I2C_OLED_ROWS - 1,
+    0, 0
+};
+
+static I2C_OLED_ClipRect clip_stack[I2C_OLED_CLIP_STACK_DEPTH];
+static uint8_t clip_stack_depth = 0;
+
+void I2C_OLED_ResetClip(void)
+{
+    clip_stack_depth = 0;
+    
+    I2C_OLED_clip.start_x = 0;
+    I2C_OLED_clip.start_y = 0;
+    I2C_OLED_clip.end_x = I2C_OLED_logical_columns - 1;
+    I2C_OLED_clip.end_y = I2C_OLED_logical_rows - 1;
+    I2C_OLED_clip.origin_x = 0;
+    I2C_OLED_clip.origin_y = 0;
+}
+
+// Trims to the logical screen, (0, 0)-(-1, -1) when nothing is left //
+
+static void I2C_OLED_TrimClip(I2C_OLED_ClipRect *clip)
+{
+    if (clip->end_x > I2C_OLED_logical_columns - 1)
+        clip->end_x = I2C_OLED_logical_columns - 1;
+    if (clip->end_y > I2C_OLED_logical_rows - 1)
+        clip->end_y = I2C_OLED_logical_rows - 1;
+    
+    if (clip->start_x > clip->end_x || clip->start_y > clip->end_y)
+    {
+        clip->start_x = 0;
+        clip->start_y = 0;
+        clip->end_x = -1;
+        clip->end_y = -1;
+    }
+}
+
+// Screen size changed: the bottom of the stack becomes the new screen, pushed clips are trimmed to it //
+
+static void I2C_OLED_FitClipToScreen(void)
+{
+    if (clip_stack_depth == 0)
+    {
+        I2C_OLED_ResetClip();
+        return;
+    }
+    
+    clip_stack[0].start_x = 0;
+    clip_stack[0].start_y = 0;
+    clip_stack[0].end_x = I2C_OLED_logical_columns - 1;
+    clip_stack[0].end_y = I2C_OLED_logical_rows - 1;
+    
+    for (uint8_t i = 1; i < clip_stack_depth; i++)
+        I2C_OLED_TrimClip(&clip_stack[i]);
+    
+    I2C_OLED_TrimClip(&I2C_OLED_clip);
+}
+
+// Rectangle is relative to the current origin, its top-left corner becomes the new origin. //
+
+bool I2C_OLED_PushClip
+(
+    int16_t start_x, int16_t start_y,
+    int16_t end_x, int16_t end_y
+)
+{
+    if (clip_stack_depth >= I2C_OLED_CLIP_STACK_DEPTH)
+        return false;
+    
+    if (start_x > end_x)
+    {
+        int16_t temp = start_x;
+        start_x = end_x;
+        end_x = temp;
+    }
+    if (start_y > end_y)
+    {
+        int16_t temp = start_y;
+        start_y = end_y;
+        end_y = temp;
+    }
+    
+    clip_stack[clip_stack_depth] = I2C_OLED_clip;
+    clip_stack_depth++;
+    
+    start_x += I2C_OLED_clip.origin_x;
+    end_x += I2C_OLED_clip.origin_x;
+    start_y += I2C_OLED_clip.origin_y;
+    end_y += I2C_OLED_clip.origin_y;
+    
+    I2C_OLED_clip.origin_x = start_x;
+    I2C_OLED_clip.origin_y = start_y;
+    
+    if (start_x > I2C_OLED_clip.start_x)
+        I2C_OLED_clip.start_x = start_x;
+    if (start_y > I2C_OLED_clip.start_y)
+        I2C_OLED_clip.start_y = start_y;
+    if (end_x < I2C_OLED_clip.end_x)
+        I2C_OLED_clip.end_x = end_x;
+    if (end_y < I2C_OLED_clip.end_y)
+        I2C_OLED_clip.end_y = end_y;
+    
+    // Empty intersection: (0, 0)-(-1, -1) rejects everything //
+    
+    if (I2C_OLED_clip.start_x > I2C_OLED_clip.end_x || I2C_OLED_clip.start_y > I2C_OLED_clip.end_y)
+    {
+        I2C_OLED_clip.start_x = 0;
+        I2C_OLED_clip.start_y = 0;
+        I2C_OLED_clip.end_x = -1;
+        I2C_OLED_clip.end_y = -1;
+    }
+    
+    return true;
+}
+
+void I2C_OLED_PopClip(void)
+{
+    if (clip_stack_depth == 0)
+        return;
+    
+    clip_stack_depth--;
+    I2C_OLED_clip = clip_stack[clip_stack_depth];
+}
+
+// Translates by the origin and trims to the clip rectangle, false if nothing is left. //
+
+static bool I2C_OLED_ClipBox
+(
+    int16_t *start_x, int16_t *start_y,
+    int16_t *end_x, int16_t *end_y
+)
+{
+    *start_x += I2C_OLED_clip.origin_x;
+    *end_x += I2C_OLED_clip.origin_x;
+    *start_y += I2C_OLED_clip.origin_y;
+    *end_y += I2C_OLED_clip.origin_y;
+    
+    if (*start_x > I2C_OLED_clip.end_x || *end_x < I2C_OLED_clip.start_x)
+        return false;
+    if (*start_y > I2C_OLED_clip.end_y || *end_y < I2C_OLED_clip.start_y)
+        return false;
+    
+    if (*start_x < I2C_OLED_clip.start_x)
+        *start_x = I2C_OLED_clip.start_x;
+    if (*end_x > I2C_OLED_clip.end_x)
+        *end_x = I2C_OLED_clip.end_x;
+    if (*start_y < I2C_OLED_clip.start_y)
+        *start_y = I2C_OLED_clip.start_y;
+    if (*end_y > I2C_OLED_clip.end_y)
+        *end_y = I2C_OLED_clip.end_y;
+    
+    return true;
+}
+
+// Rows of the clip rectangle inside a page //
+
+static uint8_t I2C_OLED_ClipPageMask(int16_t page)
+{
+    int16_t row_first = page * 8;
+    int16_t row_last = row_first + 7;
+    
+    if (row_first > I2C_OLED_clip.end_y || row_last < I2C_OLED_clip.start_y)
+        return 0x00;
+    
+    uint8_t mask = 0xFF;
+    
+    if (row_first < I2C_OLED_clip.start_y)
+        mask &= 0xFF << (I2C_OLED_clip.start_y - row_first);
+    if (row_last > I2C_OLED_clip.end_y)
+        mask &= 0xFF >> (row_last - I2C_OLED_clip.end_y);
+    
+    return mask;
+}
+
+// Raster kernels //
+
+/*
+    The raster op and the clip case are picked once per call, the kernels
+    below then run without a branch per byte. A zero mask leaves a byte
+    untouched for every op, so clipped pages need no special case either.
+    Only the kernels something uses are instantiated.
+*/
+
+#define I2C_OLED_RASTER_OP_SET(destination, pixels, mask)      ((destination) | ((pixels) & (mask)))
+#define I2C_OLED_RASTER_OP_CLEAR(destination, pixels, mask)    ((destination) & ~((pixels) & (mask)))
+#define I2C_OLED_RASTER_OP_XOR(destination, pixels, mask)      ((destination) ^ ((pixels) & (mask)))
+#define I2C_OLED_RASTER_OP_COPY(destination, pixels, mask)     (((destination) & ~(mask)) | ((pixels) & (mask)))
+
+// Every byte gets the same pixels //
+#define I2C_OLED_DEFINE_RASTER_SPAN(name, op)                                                       \
+    static void I2C_OLED_RasterSpan_##name(uint8_t *ptr_buffer, int count, uint8_t mask)            \
+    {                                                                                               \
+        for (int i = 0; i < count; i++)                                                             \
+        {                                                                                           \
+            *ptr_buffer = op(*ptr_buffer, 0xFF, mask);                                              \
+            ptr_buffer++;                                                                           \
+        }                                                                                           \
+    }
+
+// Source bytes aligned to the page //
+#define I2C_OLED_DEFINE_RASTER_BLIT(name, op)                                                       \
+    static void I2C_OLED_RasterBlit_##name                                                          \
+    (                                                                                               \
+        uint8_t *ptr_buffer,                                                                        \
+        const uint8_t *ptr_source, int count,                                                       \
+        uint8_t mask                                                                                \
+    )                                                                                               \
+    {                                                                                               \
+        for (int i = 0; i < count; i++)                                                             \
+        {                                                                                           \
+            *ptr_buffer = op(*ptr_buffer, *ptr_source, mask);                                       \
+            ptr_buffer++;                                                                           \
+            ptr_source++;                                                                           \
+        }                                                                                           \
+    }
+
+// Source bytes shifted down by shift rows (1-7), split over two pages //
+#define I2C_OLED_DEFINE_RASTER_BLIT_SHIFTED(name, op)                                               \
+    static void I2C_OLED_RasterBlitShifted_##name                                                   \
+    (                                                                                               \
+        uint8_t *ptr_buffer_upper, uint8_t *ptr_buffer_lower,                                       \
+        const uint8_t *ptr_source, int count,                                                       \
+        uint8_t shift, uint8_t mask_upper, uint8_t mask_lower                                       \
+    )                                                                                               \
+    {                                                                                               \
+        uint8_t shift_lower = 8 - shift;                                                            \
+                                                                                                    \
+        for (int i = 0; i < count; i++)                                                             \
+        {                                                                                           \
+            uint8_t pixels = *ptr_source;                                                           \
+                                                                                                    \
+            *ptr_buffer_upper = op(*ptr_buffer_upper, (uint8_t)(pixels << shift), mask_upper);      \
+            *ptr_buffer_lower = op(*ptr_buffer_lower, (uint8_t)(pixels >> shift_lower), mask_lower);\
+                                                                                                    \
+            ptr_buffer_upper++;                                                                     \
+            ptr_buffer_lower++;                                                                     \
+            ptr_source++;                                                                           \
+        }                                                                                           \
+    }
+
+I2C_OLED_DEFINE_RASTER_SPAN(Set, I2C_OLED_RASTER_OP_SET)
+I2C_OLED_DEFINE_RASTER_SPAN(Clear, I2C_OLED_RASTER_OP_CLEAR)
+I2C_OLED_DEFINE_RASTER_SPAN(Xor, I2C_OLED_RASTER_OP_XOR)
+
+I2C_OLED_DEFINE_RASTER_BLIT(Set, I2C_OLED_RASTER_OP_SET)
+I2C_OLED_DEFINE_RASTER_BLIT(Clear, I2C_OLED_RASTER_OP_CLEAR)
+I2C_OLED_DEFINE_RASTER_BLIT(Copy, I2C_OLED_RASTER_OP_COPY)
+
+I2C_OLED_DEFINE_RASTER_BLIT_SHIFTED(Set, I2C_OLED_RASTER_OP_SET)
+I2C_OLED_DEFINE_RASTER_BLIT_SHIFTED(Clear, I2C_OLED_RASTER_OP_CLEAR)
+I2C_OLED_DEFINE_RASTER_BLIT_SHIFTED(Copy, I2C_OLED_RASTER_OP_COPY)
+
+typedef void (*I2C_OLED_RasterBlitKernel)(uint8_t *, const uint8_t *, int, uint8_t);
+typedef void (*I2C_OLED_RasterBlitShiftedKernel)(uint8_t *, uint8_t *, const uint8_t *, int, uint8_t, uint8_t, uint8_t);
+
+// Dirty area //
+
+// Absolute logical coordinates. Sent right away unless manual update or double buffering is on, then accumulated. //
+
+void I2C_OLED_MarkDirty
+(
+    int16_t start_x, int16_t start_y,
+    int16_t end_x, int16_t end_y
+)
+{
+    if (start_x < 0)
+        start_x = 0;
+    if (end_x >= I2C_OLED_logical_columns)
+        end_x = I2C_OLED_logical_columns - 1;
+    if (start_y < 0)
+        start_y = 0;
+    if (end_y >= I2C_OLED_logical_rows)
+        end_y = I2C_OLED_logical_rows - 1;
+    
+    if (start_x > end_x || start_y > end_y)
+        return;
+    
+    if (!I2C_OLED_manual_update && !I2C_OLED_double_buffer)
+    {
+        I2C_OLED_UpdatePartially(start_x, end_x, start_y / 8, end_y / 8);
+        return;
+    }
+    
+    if (I2C_OLED_dirty.start_x > I2C_OLED_dirty.end_x)
+    {
+        I2C_OLED_dirty.start_x = start_x;
+        I2C_OLED_dirty.start_y = start_y;
+        I2C_OLED_dirty.end_x = end_x;
+        I2C_OLED_dirty.end_y = end_y;
+        return;
+    }
+    
+    if (start_x < I2C_OLED_dirty.start_x)
+        I2C_OLED_dirty.start_x = start_x;
+    if (start_y < I2C_OLED_dirty.start_y)
+        I2C_OLED_dirty.start_y = start_y;
+    if (end_x > I2C_OLED_dirty.end_x)
+        I2C_OLED_dirty.end_x = end_x;
+    if (end_y > I2C_OLED_dirty.end_y)
+        I2C_OLED_dirty.end_y = end_y;
+}
+
+void I2C_OLED_UpdateDirty(void)
+{
+    if (I2C_OLED_dirty.start_x > I2C_OLED_dirty.end_x)
+        return;
+    
+    if (I2C_OLED_double_buffer)
+    {
+        // Hidden half gets this frame's and the previous frame's changes, then it is shown //
+        
+        I2C_OLED_Rect presented = I2C_OLED_dirty;
+        I2C_OLED_Rect area = I2C_OLED_dirty;
+        
+        if (back_stale.start_x <= back_stale.end_x)
+        {
+            if (back_stale.start_x < area.start_x)
+                area.start_x = back_stale.start_x;
+            if (back_stale.start_y < area.start_y)
+                area.start_y = back_stale.start_y;
+            if (back_stale.end_x > area.end_x)
+                area.end_x = back_stale.end_x;
+            if (back_stale.end_y > area.end_y)
+                area.end_y = back_stale.end_y;
+        }
+        
+        I2C_OLED_UpdatePartially(area.start_x, area.end_x, area.start_y / 8, area.end_y / 8);
+        I2C_OLED_Flip(&presented);
+    }
+    else
+    {
+        I2C_OLED_UpdatePartially(I2C_OLED_dirty.start_x, I2C_OLED_dirty.end_x, I2C_OLED_dirty.start_y / 8, I2C_OLED_dirty.end_y / 8);
+    }
+    
+    I2C_OLED_dirty.start_x = 0;
+    I2C_OLED_dirty.start_y = 0;
+    I2C_OLED_dirty.end_x = -1;
+    I2C_OLED_dirty.end_y = -1;
+}
+
+void I2C_OLED_PutCharDirect(char character, bool inverted)
+{
+    if ((uint8_t)character < 0x20 || (uint8_t)character > 0x7F)
+        character = 0x20;
+    
+    int index_of_glyph = character - 0x20;
+    
+    // Glyph and spacing column in one write //
+    
+    uint8_t glyph_buffer[6];
+    
+    uint8_t *ptr_glyph_source = (uint8_t *)Font_VertHorz_ascii[index_of_glyph];
+    uint8_t *ptr_glyph_buffer = glyph_buffer;
+    
+    uint8_t pixels_xor = 0x00;
+    if (inverted)
+        pixels_xor = 0xFF;
+    
+    for (int i = 0; i < 5; i++)
+    {
+        *ptr_glyph_buffer = *ptr_glyph_source ^ pixels_xor;
+        
+        ptr_glyph_buffer++;
+        ptr_glyph_source++;
+    }
+    
+    glyph_buffer[5] = 0x00;
+    
+    I2C_OLED_WriteToRAM(glyph_buffer, 6);
+}
+
+void I2C_OLED_PrintStrDirect(const char *str, bool inverted)
+{
+    if (str == NULL)
+        return;
+    
+    while (*str)
+    {
+        I2C_OLED_PutCharDirect(*str, inverted);
+        str++;
+    }
+}
+
+void I2C_OLED_PutChar(char character, bool inverted)
+{
+    if ((uint8_t)character < 0x20 || (uint8_t)character > 0x7F)
+        character = 0x20;
+    
+    uint8_t start_column = I2C_OLED_cursor_column;
+    
+    int index_of_glyph = character - 0x20;
+    
+    // Glyph stops at the right edge of the screen //
+    
+    int16_t end_column = start_column + 4;
+    if (end_column > I2C_OLED_logical_columns - 1)
+        end_column = I2C_OLED_logical_columns - 1;
+    
+    // Cursor is absolute, only the clip rectangle applies //
+    
+    int16_t first_visible = start_column;
+    int16_t last_visible = end_column;
+    
+    if (first_visible < I2C_OLED_clip.start_x)
+        first_visible = I2C_OLED_clip.start_x;
+    if (last_visible > I2C_OLED_clip.end_x)
+        last_visible = I2C_OLED_clip.end_x;
+    
+    if (first_visible <= last_visible)
+    {
+        void (*blit)(uint8_t *, const uint8_t *, int, uint8_t) = inverted ? I2C_OLED_RasterBlit_Clear : I2C_OLED_RasterBlit_Set;
+        
+        blit
+        (
+            &I2C_OLED_buffer[(I2C_OLED_cursor_page * I2C_OLED_logical_columns) + first_visible],
+            Font_VertHorz_ascii[index_of_glyph] + (first_visible - start_column),
+            last_visible - first_visible + 1,
+            I2C_OLED_ClipPageMask(I2C_OLED_cursor_page)
+        );
+    }
+    
+    if (start_column + 4 < I2C_OLED_logical_columns - 1)
+        I2C_OLED_cursor_column = start_column + 6;
+    else if (start_column < end_column)
+        I2C_OLED_cursor_column = end_column + 1;
+    else
+        I2C_OLED_cursor_column = start_column + 1;
+    
+    I2C_OLED_MarkDirty(start_column, I2C_OLED_cursor_page * 8, I2C_OLED_cursor_column, (I2C_OLED_cursor_page * 8) + 7);
+}
+
+void I2C_OLED_PrintStr(const char *str, bool inverted)
+{
+    if (str == NULL)
+        return;
+    
+    while (*str)
+    {
+        I2C_OLED_PutChar(*str, inverted);
+        str++;
+    }
+}
+
+// Absolute coordinates, sorted and inside the clip rectangle //
+
+static void I2C_OLED_FillRectClipped
+(
+    int16_t start_x, int16_t start_y,
+    int16_t end_x, int16_t end_y,
+    bool inverted
+)
+{
+    uint8_t page_start_y = start_y / 8;
+    uint8_t page_end_y = end_y / 8;
+    
+    uint8_t start_y_mod_8 = start_y & 0x07;
+    uint8_t end_y_mod_8 = end_y & 0x07;
+    uint8_t end_y_shift = 7 - end_y_mod_8;
+    
+    uint8_t mask_edge_vert_upper = 0xFF << start_y_mod_8;
+    uint8_t mask_edge_vert_lower = 0xFF >> end_y_shift;
+    
+    int columns = end_x - start_x + 1;
+    
+    void (*span)(uint8_t *, int, uint8_t) = inverted ? I2C_OLED_RasterSpan_Clear : I2C_OLED_RasterSpan_Set;
+    
+    if (page_start_y == page_end_y)
+    {
+        // When upper edge and lower edge is in the same page //
+        
+        span(&I2C_OLED_buffer[(I2C_OLED_logical_columns * page_start_y) + start_x], columns, mask_edge_vert_upper & mask_edge_vert_lower);
+    }
+    else
+    {
+        // Upper edge, lower edge //
+        
+        span(&I2C_OLED_buffer[(I2C_OLED_logical_columns * page_start_y) + start_x], columns, mask_edge_vert_upper);
+        span(&I2C_OLED_buffer[(I2C_OLED_logical_columns * page_end_y) + start_x], columns, mask_edge_vert_lower);
+        
+        // Middle, whole bytes are stored without reading //
+        
+        uint8_t pixels = inverted ? 0x00 : 0xFF;
+        
+        for (int i = page_start_y + 1; i < page_end_y; i++)
+            memset(&I2C_OLED_buffer[(I2C_OLED_logical_columns * i) + start_x], pixels, columns);
+    }
+}
+
+// Out of bounds shapes are allowed. //
+
+void I2C_OLED_DrawRect
+(
+    int16_t start_x, int16_t start_y,
+    int16_t end_x, int16_t end_y,
+    bool inverted
+)
+{
+    // start_x/y can be smaller than end_x/y //
+    
+    if (start_x > end_x)
+    {
+        int16_t temp = start_x;
+        start_x = end_x;
+        end_x = temp;
+    }
+    if (start_y > end_y)
+    {
+        int16_t temp = start_y;
+        start_y = end_y;
+        end_y = temp;
+    }
+    
+    int16_t box_start_x = start_x;
+    int16_t box_start_y = start_y;
+    int16_t box_end_x = end_x;
+    int16_t box_end_y = end_y;
+    
+    if (!I2C_OLED_ClipBox(&box_start_x, &box_start_y, &box_end_x, &box_end_y))
+        return;
+    
+    start_x += I2C_OLED_clip.origin_x;
+    end_x += I2C_OLED_clip.origin_x;
+    start_y += I2C_OLED_clip.origin_y;
+    end_y += I2C_OLED_clip.origin_y;
+    
+    // Each edge is trimmed to the clipped box, edges outside of it are skipped //
+    
+    if (start_y == box_start_y)
+        I2C_OLED_FillRectClipped(box_start_x, start_y, box_end_x, start_y, inverted);
+    
+    if (end_y == box_end_y && end_y != start_y)
+        I2C_OLED_FillRectClipped(box_start_x, end_y, box_end_x, end_y, inverted);
+    
+    if (start_x == box_start_x)
+        I2C_OLED_FillRectClipped(start_x, box_start_y, start_x, box_end_y, inverted);
+    
+    if (end_x == box_end_x && end_x != start_x)
+        I2C_OLED_FillRectClipped(end_x, box_start_y, end_x, box_end_y, inverted);
+    
+    I2C_OLED_MarkDirty(box_start_x, box_start_y, box_end_x, box_end_y);
+}
+
+void I2C_OLED_FillRect
+(
+    int16_t start_x, int16_t start_y,
+    int16_t end_x, int16_t end_y,
+    bool inverted
+)
+{
+    // start_x/y can be smaller than end_x/y //
+    
+    if (start_x > end_x)
+    {
+        int16_t temp = start_x;
+        start_x = end_x;
+        end_x = temp;
+    }
+    if (start_y > end_y)
+    {
+        int16_t temp = start_y;
+        start_y = end_y;
+        end_y = temp;
+    }
+    
+    if (!I2C_OLED_ClipBox(&start_x, &start_y, &end_x, &end_y))
+        return;
+    
+    I2C_OLED_FillRectClipped(start_x, start_y, end_x, end_y, inverted);
+    
+    I2C_OLED_MarkDirty(start_x, start_y, end_x, end_y);
+}
+
+/*
+    Bayer 8x8 index matrix scaled to 0-255 ((index * 4) + 2).
+    Indexed with screen coordinates so that adjacent blits line up.
+*/
+static const uint8_t bayer_8x8_thresholds[8][8] =
+{
+    { 0x02, 0x82, 0x22, 0xA2, 0x0A, 0x8A, 0x2A, 0xAA },
+    { 0xC2, 0x42, 0xE2, 0x62, 0xCA, 0x4A, 0xEA, 0x6A },
+    { 0x32, 0xB2, 0x12, 0x92, 0x3A, 0xBA, 0x1A, 0x9A },
+    { 0xF2, 0x72, 0xD2, 0x52, 0xFA, 0x7A, 0xDA, 0x5A },
+    { 0x0E, 0x8E, 0x2E, 0xAE, 0x06, 0x86, 0x26, 0xA6 },
+    { 0xCE, 0x4E, 0xEE, 0x6E, 0xC6, 0x46, 0xE6, 0x66 },
+    { 0x3E, 0xBE, 0x1E, 0x9E, 0x36, 0xB6, 0x16, 0x96 },
+    { 0xFE, 0x7E, 0xDE, 0x5E, 0xF6, 0x76, 0xD6, 0x56 },
+};
+
+// Two rows of diffused error, padded by one column on each side. //
+static int16_t dither_error_current[I2C_OLED_COLUMNS + 2];
+static int16_t dither_error_next[I2C_OLED_COLUMNS + 2];
+
+void I2C_OLED_DrawGrayscale
+(
+    const uint8_t *pixels,
+    int16_t x, int16_t y,
+    int16_t width, int16_t height,
+    I2C_OLED_DitherMode dither_mode,
+    bool inverted
+)
+{
+    if (pixels == NULL || width <= 0 || height <= 0)
+        return;
+    
+    int16_t start_x = x;
+    int16_t start_y = y;
+    int16_t end_x = x + width - 1;
+    int16_t end_y = y + height - 1;
+    
+    if (!I2C_OLED_ClipBox(&start_x, &start_y, &end_x, &end_y))
+        return;
+    
+    x += I2C_OLED_clip.origin_x;
+    y += I2C_OLED_clip.origin_y;
+    
+    uint8_t page_start_y = start_y / 8;
+    uint8_t page_end_y = end_y / 8;
+    
+    int16_t columns = end_x - start_x + 1;
+    
+    // Every output byte is built in here first, then written to the buffer once. //
+    uint8_t column_bits[I2C_OLED_COLUMNS];
+    
+    if (dither_mode == I2C_OLED_DITHER_FLOYD_STEINBERG)
+    {
+        // Diffusion starts at the first visible row and column //
+        
+        memset(dither_error_current, 0, sizeof(dither_error_current));
+        memset(dither_error_next, 0, sizeof(dither_error_next));
+    }
+    
+    for (int page = page_start_y; page <= page_end_y; page++)
+    {
+        int16_t row_first = page * 8;
+        int16_t row_last = row_first + 7;
+        
+        if (row_first < start_y)
+            row_first = start_y;
+        if (row_last > end_y)
+            row_last = end_y;
+        
+        uint8_t mask = (uint8_t)(0xFF << (row_first & 0x07)) & (uint8_t)(0xFF >> (7 - (row_last & 0x07)));
+        
+        const uint8_t *ptr_source_page = pixels + ((row_first - y) * width) + (start_x - x);
+        
+        if (dither_mode == I2C_OLED_DITHER_FLOYD_STEINBERG)
+        {
+            memset(column_bits, 0, columns);
+            
+            const uint8_t *ptr_source_row = ptr_source_page;
+            
+            for (int row = row_first; row <= row_last; row++)
+            {
+                uint8_t bit = 1 << (row & 0x07);
+                
+                int16_t *ptr_error = dither_error_current + 1;
+                int16_t *ptr_error_next = dither_error_next + 1;
+                
+                for (int i = 0; i < columns; i++)
+                {
+                    int16_t value = ptr_source_row[i] + ptr_error[i];
+                    int16_t error = value;
+                    
+                    if (value >= 0x80)
+                    {
+                        column_bits[i] |= bit;
+                        error = value - 0xFF;
+                    }
+                    
+                    ptr_error[i + 1]      += (error * 7) / 16;
+                    ptr_error_next[i - 1] += (error * 3) / 16;
+                    ptr_error_next[i]     += (error * 5) / 16;
+                    ptr_error_next[i + 1] += error / 16;
+                }
+                
+                memcpy(dither_error_current, dither_error_next, sizeof(dither_error_current));
+                memset(dither_error_next, 0, sizeof(dither_error_next));
+                
+                ptr_source_row += width;
+            }
+        }
+        else
+        {
+            int rows = row_last - row_first + 1;
+            uint8_t first_bit = row_first & 0x07;
+            
+            for (int i = 0; i < columns; i++)
+            {
+                const uint8_t *ptr_source = ptr_source_page + i;
+                uint8_t pixels_vert = 0x00;
+                
+                if (dither_mode == I2C_OLED_DITHER_BAYER)
+                {
+                    uint8_t column_mod_8 = (start_x + i) & 0x07;
+                    
+                    for (int j = 0; j < rows; j++)
+                    {
+                        uint8_t bit_index = first_bit + j;
+                        
+                        pixels_vert |= (*ptr_source > bayer_8x8_thresholds[bit_index][column_mod_8]) << bit_index;
+                        ptr_source += width;
+                    }
+                }
+                else
+                {
+                    for (int j = 0; j < rows; j++)
+                    {
+                        pixels_vert |= (*ptr_source >= 0x80) << (first_bit + j);
+                        ptr_source += width;
+                    }
+                }
+                
+                column_bits[i] = pixels_vert;
+            }
+        }
+        
+        // Copied under the mask, inverting afterwards flips exactly the copied rows //
+        
+        uint8_t *ptr_buffer = &I2C_OLED_buffer[(I2C_OLED_logical_columns * page) + start_x];
+        
+        I2C_OLED_RasterBlit_Copy(ptr_buffer, column_bits, columns, mask);
+        
+        if (inverted)
+            I2C_OLED_RasterSpan_Xor(ptr_buffer, columns, mask);
+    }
+    
+    I2C_OLED_MarkDirty(start_x, start_y, end_x, end_y);
+}
+
+// Points //
+
+// Buffer byte index of a point (absolute), -1 when clipped //
+static int16_t I2C_OLED_PointKey(const I2C_OLED_Point *point)
+{
+    int16_t x = point->x + I2C_OLED_clip.origin_x;
+    int16_t y = point->y + I2C_OLED_clip.origin_y;
+    
+    if (x < I2C_OLED_clip.start_x || x > I2C_OLED_clip.end_x || y < I2C_OLED_clip.start_y || y > I2C_OLED_clip.end_y)
+        return -1;
+    
+    return ((y >> 3) * I2C_OLED_logical_columns) + x;
+}
+
+// Shell sort by buffer byte, skipped when the points are already in order //
+
+static void I2C_OLED_SortPoints(I2C_OLED_Point *points, uint16_t count)
+{
+    static const uint16_t gaps[] = { 701, 301, 132, 57, 23, 10, 4, 1 };
+    
+    bool sorted = true;
+    
+    for (int i = 1; i < count; i++)
+    {
+        if (I2C_OLED_PointKey(&points[i - 1]) > I2C_OLED_PointKey(&points[i]))
+        {
+            sorted = false;
+            break;
+        }
+    }
+    
+    if (sorted)
+        return;
+    
+    for (size_t g = 0; g < sizeof(gaps) / sizeof(gaps[0]); g++)
+    {
+        uint16_t gap = gaps[g];
+        
+        for (int i = gap; i < count; i++)
+        {
+            I2C_OLED_Point point = points[i];
+            int16_t key = I2C_OLED_PointKey(&point);
+            
+            int j = i;
+            
+            while (j >= gap && I2C_OLED_PointKey(&points[j - gap]) > key)
+            {
+                points[j] = points[j - gap];
+                j -= gap;
+            }
+            
+            points[j] = point;
+        }
+    }
+}
+
+void I2C_OLED_PlotPoints(I2C_OLED_Point *points, uint16_t count, I2C_OLED_PixelOp op)
+{
+    if (points == NULL || count == 0)
+        return;
+    
+    I2C_OLED_SortPoints(points, count);
+    
+    int16_t box_start_x = I2C_OLED_logical_columns;
+    int16_t box_start_y = I2C_OLED_logical_rows;
+    int16_t box_end_x = -1;
+    int16_t box_end_y = -1;
+    
+    int i = 0;
+    
+    while (i < count)
+    {
+        int16_t key = I2C_OLED_PointKey(&points[i]);
+        
+        if (key < 0)
+        {
+            i++;
+            continue;
+        }
+        
+        // Merge every point that lands in the same byte //
+        
+        uint8_t bits = 0x00;
+        
+        do
+        {
+            uint8_t bit = 1 << ((points[i].y + I2C_OLED_clip.origin_y) & 0x07);
+            
+            if (op == I2C_OLED_PIXEL_XOR)
+                bits ^= bit;
+            else
+                bits |= bit;
+            
+            i++;
+        }
+        while (i < count && I2C_OLED_PointKey(&points[i]) == key);
+        
+        if (op == I2C_OLED_PIXEL_SET)
+            I2C_OLED_buffer[key] |= bits;
+        else if (op == I2C_OLED_PIXEL_CLEAR)
+            I2C_OLED_buffer[key] &= ~bits;
+        else
+            I2C_OLED_buffer[key] ^= bits;
+        
+        // Bounding box //
+        
+        int16_t x = key % I2C_OLED_logical_columns;
+        int16_t page = key / I2C_OLED_logical_columns;
+        
+        if (x < box_start_x)
+            box_start_x = x;
+        if (x > box_end_x)
+            box_end_x = x;
+        if (page * 8 < box_start_y)
+            box_start_y = page * 8;
+        if ((page * 8) + 7 > box_end_y)
+            box_end_y = (page * 8) + 7;
+    }
+    
+    if (box_end_x >= 0)
+        I2C_OLED_MarkDirty(box_start_x, box_start_y, box_end_x, box_end_y);
+}
+
+void I2C_OLED_GetStrSizeXY(const char *str, int *out_width, int *out_height)
+{
+    char *ptr_str = (char *)str;
+    
+    int text_width = 0;
+    int width_current_line = 0;
+    
+    int text_height = 8;
+    
+    while (*ptr_str)
+    {
+        char current_char = *ptr_str;
+        
+        ptr_str++;
+        
+        if (current_char == '\n')
+        {
+            text_height += 8;
+            
+            width_current_line = 0;
+            continue;
+        }
+        
+        if (current_char == '\r')
+            continue;
+        
+        width_current_line += 6;
+        
+        if (width_current_line > text_width)
+            text_width = width_current_line;
+    }
+    
+    if (out_width != NULL)
+        *out_width = text_width;
+    
+    if (out_height != NULL)
+        *out_height = text_height;
+}
+
+// Regions //
+
+bool I2C_OLED_SaveRegion
+(
+    I2C_OLED_Region *region,
+    int16_t start_x, int16_t start_y,
+    int16_t end_x, int16_t end_y,
+    uint8_t *pool, uint16_t pool_size
+)
+{
+    if (region == NULL)
+        return false;
+    
+    region->pixels = NULL;
+    
+    if (pool == NULL)
+        return false;
+    
+    if (start_x > end_x)
+    {
+        int16_t temp = start_x;
+        start_x = end_x;
         end_x = temp;
     }
     if (start_y > end_y)
@@ -343,217 +1837,454 @@ void I2C_OLED_DrawRect
         end_y = temp;
     }
     
-    if (start_x < 0 && end_x >= I2C_OLED_COLUMNS && start_y < 0 && end_y >= I2C_OLED_ROWS)
+    if (!I2C_OLED_ClipBox(&start_x, &start_y, &end_x, &end_y))
+        return false;
+    
+    int16_t columns = end_x - start_x + 1;
+    int16_t start_page = start_y / 8;
+    int16_t end_page = end_y / 8;
+    
+    if ((uint32_t)columns * (end_page - start_page + 1) > pool_size)
+        return false;
+    
+    uint8_t *ptr_pool = pool;
+    
+    for (int page = start_page; page <= end_page; page++)
+    {
+        memcpy(ptr_pool, &I2C_OLED_buffer[(page * I2C_OLED_logical_columns) + start_x], columns);
+        ptr_pool += columns;
+    }
+    
+    region->pixels = pool;
+    region->start_x = start_x;
+    region->end_x = end_x;
+    region->start_page = start_page;
+    region->end_page = end_page;
+    
+    return true;
+}
+
+void I2C_OLED_RestoreRegion(I2C_OLED_Region *region)
+{
+    if (region == NULL || region->pixels == NULL)
         return;
     
-    if ((start_x >= I2C_OLED_COLUMNS || end_x < 0) && (start_y >= I2C_OLED_ROWS || end_y < 0))
+    // Rotation may have changed since the save //
+    
+    if (region->end_x >= I2C_OLED_logical_columns || region->end_page >= I2C_OLED_logical_pages)
         return;
     
-    bool start_x_in_bound = start_x >= 0;
-    bool end_x_in_bound = end_x < I2C_OLED_COLUMNS;
-    bool start_y_in_bound = start_y >= 0;
-    bool end_y_in_bound = end_y < I2C_OLED_ROWS;
+    int16_t columns = region->end_x - region->start_x + 1;
     
-    uint8_t page_start_y = 0;
-    uint8_t page_end_y = I2C_OLED_PAGES - 1;
-    if (start_y_in_bound)
-        page_start_y = start_y / 8;
-    if (end_y_in_bound)
-        page_end_y = end_y / 8;
+    const uint8_t *ptr_pool = region->pixels;
     
-    uint8_t start_y_mod_8 = start_y & 0x07;
-    uint8_t end_y_mod_8 = end_y & 0x07;
-    uint8_t end_y_shift = 7 - end_y_mod_8;
+    for (int page = region->start_page; page <= region->end_page; page++)
+    {
+        memcpy(&I2C_OLED_buffer[(page * I2C_OLED_logical_columns) + region->start_x], ptr_pool, columns);
+        ptr_pool += columns;
+    }
     
-    uint8_t mask_edge_vert_upper = 0xFF << start_y_mod_8;
-    uint8_t mask_edge_vert_lower = 0xFF >> end_y_shift;
+    I2C_OLED_MarkDirty(region->start_x, region->start_page * 8, region->end_x, (region->end_page * 8) + 7);
+}
+
+/*
+    Blits columns x 8 pixels at x, y through the given kernels, out_box gets
+    the absolute area that was touched. Unaligned, the row masks keep the
+    kernels to the cell rows: copy needs that, set and clear never see
+    pixels outside them anyway.
+*/
+static inline bool I2C_OLED_BlitCellXY
+(
+    const uint8_t *pixels, int16_t columns,
+    int16_t x, int16_t y,
+    I2C_OLED_RasterBlitKernel blit,
+    I2C_OLED_RasterBlitShiftedKernel blit_shifted,
+    I2C_OLED_Rect *out_box
+)
+{
+    int16_t start_x = x;
+    int16_t start_y = y;
+    int16_t end_x = x + columns - 1;
+    int16_t end_y = y + 7;
     
-    uint8_t edge_horz_upper = 0x01 << start_y_mod_8;
-    uint8_t edge_horz_lower = 0x01 << end_y_mod_8;
+    if (!I2C_OLED_ClipBox(&start_x, &start_y, &end_x, &end_y))
+        return false;
     
-    uint16_t buffer_offset;
+    x += I2C_OLED_clip.origin_x;
+    y += I2C_OLED_clip.origin_y;
     
-    uint8_t horz_start_x = 0;
-    uint8_t horz_end_x = I2C_OLED_COLUMNS - 1;
-    if (start_x_in_bound)
-        horz_start_x = start_x;
-    if (end_x_in_bound)
-        horz_end_x = end_x;
+    // Floor division, y can be negative //
     
-    if (page_start_y == page_end_y)
+    int16_t y_mod_8 = y & 0x07;
+    int16_t page_y = (y - y_mod_8) / 8;
+    
+    const uint8_t *ptr_pixels = pixels + (start_x - x);
+    int count = end_x - start_x + 1;
+    
+    if (y_mod_8 == 0)
     {
-        buffer_offset = I2C_OLED_COLUMNS * page_start_y;
+        // If y is aligned to page //
         
-        uint8_t edge_vert = mask_edge_vert_upper & mask_edge_vert_lower;
-        uint8_t edges_horz = edge_horz_upper | edge_horz_lower;
+        blit(&I2C_OLED_buffer[(I2C_OLED_logical_columns * page_y) + start_x], ptr_pixels, count, I2C_OLED_ClipPageMask(page_y));
+    }
+    else
+    {
+        // If y is not aligned to page //
         
-        if (start_x_in_bound)
-        {
-            if (!inverted)
-                I2C_OLED_buffer[buffer_offset + horz_start_x] |= edge_vert;
-            else
-                I2C_OLED_buffer[buffer_offset + horz_start_x] &= ~edge_vert;
-            
-            horz_start_x += 1;
-        }
+        uint8_t mask_upper = I2C_OLED_ClipPageMask(page_y) & (uint8_t)(0xFF << y_mod_8);
+        uint8_t mask_lower = I2C_OLED_ClipPageMask(page_y + 1) & (0xFF >> (8 - y_mod_8));
         
-        if (end_x_in_bound)
-        {
-            if (!inverted)
-                I2C_OLED_buffer[buffer_offset + horz_end_x] |= edge_vert;
-            else
-                I2C_OLED_buffer[buffer_offset + horz_end_x] &= ~edge_vert;
-            horz_end_x -= 1;
-        }
+        // A page without visible rows may be off screen, point it at the other one, its zero mask leaves it as is //
         
-        uint8_t *ptr_buffer = I2C_OLED_buffer + buffer_offset + horz_start_x;
+        int16_t page_upper = page_y;
+        int16_t page_lower = page_y + 1;
+        if (!mask_upper)
+            page_upper = page_lower;
+        if (!mask_lower)
+            page_lower = page_upper;
         
-        if (!inverted)
-        {
-            for (int i = horz_start_x; i <= horz_end_x; i++)
-            {
-                *ptr_buffer |= edges_horz;
-                ptr_buffer++;
-            }
-        }
-        else
-        {
-            uint8_t edges_horz_inverted = ~edges_horz;
-            
-            for (int i = horz_start_x; i <= horz_end_x; i++)
-            {
-                *ptr_buffer &= edges_horz_inverted;
-                ptr_buffer++;
-            }
-        }
+        blit_shifted
+        (
+            &I2C_OLED_buffer[(I2C_OLED_logical_columns * page_upper) + start_x],
+            &I2C_OLED_buffer[(I2C_OLED_logical_columns * page_lower) + start_x],
+            ptr_pixels, count,
+            y_mod_8, mask_upper, mask_lower
+        );
     }
-    else
+    
+    out_box->start_x = start_x;
+    out_box->start_y = start_y;
+    out_box->end_x = end_x;
+    out_box->end_y = end_y;
+    
+    return true;
+}
+
+// Draws a 5-column glyph, out_box gets the absolute area that was touched //
+
+static bool I2C_OLED_DrawGlyphXY
+(
+    const uint8_t *glyph,
+    int16_t x, int16_t y,
+    bool inverted,
+    I2C_OLED_Rect *out_box
+)
+{
+    if (inverted)
+        return I2C_OLED_BlitCellXY(glyph, 5, x, y, I2C_OLED_RasterBlit_Clear, I2C_OLED_RasterBlitShifted_Clear, out_box);
+    
+    return I2C_OLED_BlitCellXY(glyph, 5, x, y, I2C_OLED_RasterBlit_Set, I2C_OLED_RasterBlitShifted_Set, out_box);
+}
+
+static void I2C_OLED_RectUnion(I2C_OLED_Rect *rect, const I2C_OLED_Rect *other)
+{
+    if (rect->start_x > rect->end_x)
     {
-        buffer_offset = I2C_OLED_COLUMNS * page_start_y;
-        
-        uint16_t buffer_offset_to_lower = I2C_OLED_COLUMNS * (page_end_y - page_start_y);
+        *rect = *other;
+        return;
+    }
+    
+    if (other->start_x < rect->start_x)
+        rect->start_x = other->start_x;
+    if (other->start_y < rect->start_y)
+        rect->start_y = other->start_y;
+    if (other->end_x > rect->end_x)
+        rect->end_x = other->end_x;
+    if (other->end_y > rect->end_y)
+        rect->end_y = other->end_y;
+}
+
+void I2C_OLED_PutCharXY
+(
+    char character,
+    int16_t x, int16_t y,
+    bool inverted
+)
+{
+    if ((uint8_t)character < 0x20 || (uint8_t)character > 0x7F)
+        return;
+    
+    I2C_OLED_Rect box;
+    
+    if (I2C_OLED_DrawGlyphXY(Font_VertHorz_ascii[character - 0x20], x, y, inverted, &box))
+        I2C_OLED_MarkDirty(box.start_x, box.start_y, box.end_x, box.end_y);
+}
+
+// Whole 6x8 cell (glyph and spacing column) replaces what was there, one dirty box //
+
+void I2C_OLED_PutCharOpaqueXY
+(
+    char character,
+    int16_t x, int16_t y,
+    bool inverted
+)
+{
+    if ((uint8_t)character < 0x20 || (uint8_t)character > 0x7F)
+        character = 0x20;
+    
+    uint8_t cell[6];
+    uint8_t pixels_xor = inverted ? 0xFF : 0x00;
+    
+    for (int i = 0; i < 5; i++)
+        cell[i] = Font_VertHorz_ascii[character - 0x20][i] ^ pixels_xor;
+    
+    cell[5] = pixels_xor;
+    
+    I2C_OLED_Rect box;
+    
+    if (I2C_OLED_BlitCellXY(cell, 6, x, y, I2C_OLED_RasterBlit_Copy, I2C_OLED_RasterBlitShifted_Copy, &box))
+        I2C_OLED_MarkDirty(box.start_x, box.start_y, box.end_x, box.end_y);
+}
+
+void I2C_OLED_PrintStrXY
+(
+    const char *str,
+    int16_t x, int16_t y,
+    bool inverted
+)
+{
+    if (str == NULL)
+        return;
+    
+    I2C_OLED_Rect dirty = { 0, 0, -1, -1 };
+    
+    int16_t current_x = x;
+    int16_t current_y = y;
+    
+    const char *ptr_str = str;
+    
+    while (*ptr_str)
+    {
+        char current_char = *ptr_str;
         
-        // Corners //
+        ptr_str++;
         
-        if (start_x_in_bound)
+        if (current_char == '\n')
         {
-            if (start_y_in_bound)
-            {
-                if (!inverted)
-                    I2C_OLED_buffer[buffer_offset + horz_start_x] |= mask_edge_vert_upper;
-                else
-                    I2C_OLED_buffer[buffer_offset + horz_start_x] &= ~mask_edge_vert_upper;
-            }
-            
-            if (end_y_in_bound)
-            {
-                if (!inverted)
-                    I2C_OLED_buffer[buffer_offset + horz_start_x + buffer_offset_to_lower] |= mask_edge_vert_lower;
-                else
-                    I2C_OLED_buffer[buffer_offset + horz_start_x + buffer_offset_to_lower] &= ~mask_edge_vert_lower;
-            }
+            current_y += 8;
             
-            horz_start_x += 1;
-        }
-        
-        if (end_x_in_bound)
-        {
-            if (start_y_in_bound)
-            {
-                if (!inverted)
-                    I2C_OLED_buffer[buffer_offset + horz_end_x] |= mask_edge_vert_upper;
-                else
-                    I2C_OLED_buffer[buffer_offset + horz_end_x] &= ~mask_edge_vert_upper;
-            }
+            if (current_y + I2C_OLED_clip.origin_y > I2C_OLED_clip.end_y)
+                break;
             
-            if (end_y_in_bound)
-            {
-                if (!inverted)
-                    I2C_OLED_buffer[buffer_offset + horz_end_x + buffer_offset_to_lower] |= mask_edge_vert_lower;
-                else
-                    I2C_OLED_buffer[buffer_offset + horz_end_x + buffer_offset_to_lower] &= ~mask_edge_vert_lower;
-            }
+            current_x = x;
             
-            horz_end_x -= 1;
+            continue;
         }
         
-        // Upper & Lower edge //
+        // Anything else takes a cell, drawn or not ('\r' included) //
         
-        uint8_t *ptr_buffer_upper = &I2C_OLED_buffer[buffer_offset + horz_start_x];
-        uint8_t *ptr_buffer_lower = &I2C_OLED_buffer[buffer_offset + buffer_offset_to_lower + horz_start_x];
+        I2C_OLED_Rect box;
         
-        if (!inverted)
+        if ((uint8_t)current_char >= 0x20 && (uint8_t)current_char <= 0x7F)
         {
-            for (int i = horz_start_x; i <= horz_end_x; i++)
-            {
-                if (start_y_in_bound)
-                    *ptr_buffer_upper |= edge_horz_upper;
-                
-                if (end_y_in_bound)
-                    *ptr_buffer_lower |= edge_horz_lower;
-                
-                ptr_buffer_upper++;
-                ptr_buffer_lower++;
-            }
+            if (I2C_OLED_DrawGlyphXY(Font_VertHorz_ascii[current_char - 0x20], current_x, current_y, inverted, &box))
+                I2C_OLED_RectUnion(&dirty, &box);
         }
-        else
+        
+        current_x += 6;
+    }
+    
+    if (dirty.start_x <= dirty.end_x)
+        I2C_OLED_MarkDirty(dirty.start_x, dirty.start_y, dirty.end_x, dirty.end_y);
+}
+
+// Label cache //
+
+/*
+    Labels are rendered once per y phase (y mod 8) into the page bytes they
+    cover, a hit only blits those bytes. Entries are replaced least
+    recently used first. Same output as I2C_OLED_PrintStrXY().
+*/
+
+typedef struct
+{
+    bool valid;
+    uint8_t y_phase;
+    uint8_t length;
+    uint32_t last_used;
+    
+    char text[I2C_OLED_LABEL_CACHE_LENGTH];
+    
+    uint8_t upper[(I2C_OLED_LABEL_CACHE_LENGTH * 6) - 1];
+    uint8_t lower[(I2C_OLED_LABEL_CACHE_LENGTH * 6) - 1];  // Unused for phase 0
+} I2C_OLED_LabelCacheEntry;
+
+static I2C_OLED_LabelCacheEntry label_cache[I2C_OLED_LABEL_CACHE_ENTRIES];
+
+static uint32_t label_cache_clock = 0;
+static uint32_t label_cache_hits = 0;
+static uint32_t label_cache_misses = 0;
+
+void I2C_OLED_ResetLabelCache(void)
+{
+    for (int i = 0; i < I2C_OLED_LABEL_CACHE_ENTRIES; i++)
+        label_cache[i].valid = false;
+    
+    label_cache_clock = 0;
+    label_cache_hits = 0;
+    label_cache_misses = 0;
+}
+
+void I2C_OLED_GetLabelCacheStatistics(uint32_t *out_hits, uint32_t *out_misses)
+{
+    if (out_hits != NULL)
+        *out_hits = label_cache_hits;
+    
+    if (out_misses != NULL)
+        *out_misses = label_cache_misses;
+}
+
+static I2C_OLED_LabelCacheEntry *I2C_OLED_LabelCacheLookup(const char *str, uint8_t length, uint8_t y_phase)
+{
+    I2C_OLED_LabelCacheEntry *entry_victim = &label_cache[0];
+    
+    for (int i = 0; i < I2C_OLED_LABEL_CACHE_ENTRIES; i++)
+    {
+        I2C_OLED_LabelCacheEntry *entry = &label_cache[i];
+        
+        if (!entry->valid)
         {
-            uint8_t edge_horz_upper_inverted = ~edge_horz_upper;
-            uint8_t edge_horz_lower_inverted = ~edge_horz_lower;
-            
-            for (int i = horz_start_x; i <= horz_end_x; i++)
-            {
-                if (start_y_in_bound)
-                    *ptr_buffer_upper &= edge_horz_upper_inverted;
-                
-                if (end_y_in_bound)
-                    *ptr_buffer_lower &= edge_horz_lower_inverted;
-                
-                ptr_buffer_upper++;
-                ptr_buffer_lower++;
-            }
+            if (entry_victim->valid)
+                entry_victim = entry;
+            continue;
         }
         
-        // Left & right edge //
+        if (entry->y_phase == y_phase && entry->length == length && memcmp(entry->text, str, length) == 0)
+        {
+            label_cache_hits++;
+            entry->last_used = ++label_cache_clock;
+            return entry;
+        }
         
-        uint16_t page_left_right_edge = page_start_y + 1;
+        if (entry_victim->valid && entry->last_used < entry_victim->last_used)
+            entry_victim = entry;
+    }
+    
+    // Miss: render into the free or least recently used entry //
+    
+    label_cache_misses++;
+    
+    I2C_OLED_LabelCacheEntry *entry = entry_victim;
+    
+    entry->valid = true;
+    entry->y_phase = y_phase;
+    entry->length = length;
+    entry->last_used = ++label_cache_clock;
+    memcpy(entry->text, str, length);
+    
+    uint8_t *ptr_upper = entry->upper;
+    uint8_t *ptr_lower = entry->lower;
+    
+    for (int i = 0; i < length; i++)
+    {
+        const uint8_t *ptr_glyph = Font_VertHorz_ascii[str[i] - 0x20];
         
-        if (page_start_y + 1 < page_end_y)
-        {        
-            uint16_t offset_left_right_edge_start = I2C_OLED_COLUMNS * page_left_right_edge;
-            
-            uint8_t *ptr_buffer_left_edge = &I2C_OLED_buffer[offset_left_right_edge_start + start_x];
-            uint8_t *ptr_buffer_right_edge = &I2C_OLED_buffer[offset_left_right_edge_start + end_x];
+        for (int j = 0; j < 6; j++)
+        {
+            if (i == length - 1 && j == 5)
+                break;
             
-            uint8_t edge_pixels;
-            if (!inverted)
-                edge_pixels = 0xFF;
-            else
-                edge_pixels = 0x00;
+            uint8_t glyph_pixels = (j < 5) ? ptr_glyph[j] : 0x00;
             
-            for (int i = page_left_right_edge; i < page_end_y; i++)
-            {
-                *ptr_buffer_left_edge = edge_pixels;
-                *ptr_buffer_right_edge = edge_pixels;
-                
-                ptr_buffer_left_edge += I2C_OLED_COLUMNS;
-                ptr_buffer_right_edge += I2C_OLED_COLUMNS;
-            }
+            *ptr_upper++ = glyph_pixels << y_phase;
+            *ptr_lower++ = (y_phase != 0) ? (glyph_pixels >> (8 - y_phase)) : 0x00;
         }
     }
     
-    if (!I2C_OLED_manual_update)
-        I2C_OLED_UpdatePartially(start_x, end_x, page_start_y, page_end_y);
+    return entry;
 }
 
-void I2C_OLED_FillRect
+void I2C_OLED_PrintLabelXY
+(
+    const char *str,
+    int16_t x, int16_t y,
+    bool inverted
+)
+{
+    if (str == NULL)
+        return;
+    
+    // Only single-line printable labels that fit an entry are cached //
+    
+    int length = 0;
+    
+    while (str[length])
+    {
+        if (length >= I2C_OLED_LABEL_CACHE_LENGTH || (uint8_t)str[length] < 0x20 || (uint8_t)str[length] > 0x7F)
+        {
+            label_cache_misses++;
+            I2C_OLED_PrintStrXY(str, x, y, inverted);
+            return;
+        }
+        
+        length++;
+    }
+    
+    if (length == 0)
+        return;
+    
+    int16_t start_x = x;
+    int16_t start_y = y;
+    int16_t end_x = x + (length * 6) - 2;
+    int16_t end_y = y + 7;
+    
+    if (!I2C_OLED_ClipBox(&start_x, &start_y, &end_x, &end_y))
+        return;
+    
+    x += I2C_OLED_clip.origin_x;
+    y += I2C_OLED_clip.origin_y;
+    
+    uint8_t y_phase = y & 0x07;
+    int16_t page_y = (y - y_phase) / 8;
+    
+    I2C_OLED_LabelCacheEntry *entry = I2C_OLED_LabelCacheLookup(str, length, y_phase);
+    
+    void (*blit)(uint8_t *, const uint8_t *, int, uint8_t) = inverted ? I2C_OLED_RasterBlit_Clear : I2C_OLED_RasterBlit_Set;
+    
+    int columns = end_x - start_x + 1;
+    int offset = start_x - x;
+    
+    // Pages without visible rows may be off screen, they are skipped //
+    
+    uint8_t mask_upper = I2C_OLED_ClipPageMask(page_y);
+    uint8_t mask_lower = (y_phase != 0) ? I2C_OLED_ClipPageMask(page_y + 1) : 0x00;
+    
+    if (mask_upper)
+        blit(&I2C_OLED_buffer[(I2C_OLED_logical_columns * page_y) + start_x], entry->upper + offset, columns, mask_upper);
+    
+    if (mask_lower)
+        blit(&I2C_OLED_buffer[(I2C_OLED_logical_columns * (page_y + 1)) + start_x], entry->lower + offset, columns, mask_lower);
+    
+    I2C_OLED_MarkDirty(start_x, start_y, end_x, end_y);
+}
+
+// Text box //
+
+static const uint8_t ellipsis_glyph[5] = { 0x40, 0x00, 0x40, 0x00, 0x40 };
+
+/*
+    Lines are laid out one at a time: a forward scan finds where the line
+    breaks and how wide it is, then the same characters are drawn. The
+    string is never measured as a whole.
+*/
+bool I2C_OLED_PrintTextBox
 (
+    const char *str,
     int16_t start_x, int16_t start_y,
     int16_t end_x, int16_t end_y,
-    bool inverted
+    I2C_OLED_TextAlign align,
+    uint8_t flags,
+    bool inverted,
+    I2C_OLED_Rect *out_dirty
 )
 {
-    // start_x/y can be smaller than end_x/y //
+    I2C_OLED_Rect dirty = { 0, 0, -1, -1 };
+    
+    if (out_dirty != NULL)
+        *out_dirty = dirty;
+    
+    if (str == NULL)
+        return true;
     
     if (start_x > end_x)
     {
@@ -568,325 +2299,208 @@ void I2C_OLED_FillRect
         end_y = temp;
     }
     
-    if ((start_x >= I2C_OLED_COLUMNS || end_x < 0) && (start_y >= I2C_OLED_ROWS || end_y < 0))
-        return;
+    int16_t box_width = end_x - start_x + 1;
+    int16_t box_height = end_y - start_y + 1;
     
-    if (start_x < 0)
-        start_x = 0;
-    if (end_x >= I2C_OLED_COLUMNS)
-        end_x = I2C_OLED_COLUMNS - 1;
+    // 5 columns per glyph plus 1 column of spacing, the last glyph needs no spacing //
     
-    if (start_y < 0)
-        start_y = 0;
-    if (end_y >= I2C_OLED_ROWS)
-        end_y = I2C_OLED_ROWS - 1;
+    int16_t line_max_chars = (box_width + 1) / 6;
     
-    bool start_y_in_bound = start_y >= 0;
-    bool end_y_in_bound = end_y < I2C_OLED_ROWS;
+    // Partly visible last line is drawn clipped, unless it would hide the ellipsis //
     
-    uint8_t page_start_y = 0;
-    uint8_t page_end_y = I2C_OLED_PAGES - 1;
-    if (start_y_in_bound)
-        page_start_y = start_y / 8;
-    if (end_y_in_bound)
-        page_end_y = end_y / 8;
+    int16_t lines_max = (box_height + 7) / 8;
+    if ((flags & I2C_OLED_TEXT_ELLIPSIS) && box_height >= 8)
+        lines_max = box_height / 8;
     
-    uint8_t start_y_mod_8 = start_y & 0x07;
-    uint8_t end_y_mod_8 = end_y & 0x07;
-    uint8_t end_y_shift = 7 - end_y_mod_8;
+    if (line_max_chars == 0)
+        return *str == '\0';
     
-    uint8_t mask_edge_vert_upper = 0xFF << start_y_mod_8;
-    uint8_t mask_edge_vert_lower = 0xFF >> end_y_shift;
+    // The box narrows the clip rectangle while drawing, no clip stack slot is used //
     
-    uint8_t *ptr_buffer = &I2C_OLED_buffer[(I2C_OLED_COLUMNS * page_start_y) + start_x];
+    I2C_OLED_ClipRect clip_saved = I2C_OLED_clip;
     
-    if (page_start_y == page_end_y)
+    int16_t clip_start_x = start_x;
+    int16_t clip_start_y = start_y;
+    int16_t clip_end_x = end_x;
+    int16_t clip_end_y = end_y;
+    
+    if (!I2C_OLED_ClipBox(&clip_start_x, &clip_start_y, &clip_end_x, &clip_end_y))
     {
-        // When upper edge and lower edge is in the same page //
+        clip_start_x = 0;
+        clip_start_y = 0;
+        clip_end_x = -1;
+        clip_end_y = -1;
+    }
+    
+    I2C_OLED_clip.start_x = clip_start_x;
+    I2C_OLED_clip.start_y = clip_start_y;
+    I2C_OLED_clip.end_x = clip_end_x;
+    I2C_OLED_clip.end_y = clip_end_y;
+    
+    const char *ptr_str = str;
+    
+    bool fit = true;
+    
+    int16_t line_y = start_y;
+    
+    for (int line = 0; line < lines_max && *ptr_str; line++)
+    {
+        // Find the end of the line //
         
-        uint8_t pixels_vert = mask_edge_vert_upper & mask_edge_vert_lower;
+        const char *ptr_line_end = NULL;
+        const char *ptr_next_line = NULL;
+        const char *ptr_last_space = NULL;
         
-        if (!inverted)
-        {
-            for (int i = start_x; i <= end_x; i++)
-            {
-                *ptr_buffer |= pixels_vert;
-                ptr_buffer++;
-            }
-        }
-        else
+        int16_t chars = 0;
+        int16_t chars_at_last_space = 0;
+        
+        bool truncated = false;
+        
+        const char *ptr_scan = ptr_str;
+        
+        for (;;)
         {
-            uint8_t pixels_vert_inverted = ~pixels_vert;
+            char current_char = *ptr_scan;
             
-            for (int i = start_x; i <= end_x; i++)
+            if (current_char == '\0' || current_char == '\n')
             {
-                *ptr_buffer &= pixels_vert_inverted;
-                ptr_buffer++;
+                ptr_line_end = ptr_scan;
+                ptr_next_line = (current_char == '\n') ? ptr_scan + 1 : ptr_scan;
+                break;
             }
-        }
-    }
-    else
-    {
-        if (!inverted)
-        {
-            // Upper edge //
             
-            for (int i = start_x; i <= end_x; i++)
+            if (current_char == '\r')
             {
-                *ptr_buffer |= mask_edge_vert_upper;
-                ptr_buffer++;
+                ptr_scan++;
+                continue;
             }
             
-            // Lower edge //
-            
-            ptr_buffer = &I2C_OLED_buffer[(I2C_OLED_COLUMNS * page_end_y) + start_x];
-            
-            for (int i = start_x; i <= end_x; i++)
+            if (chars == line_max_chars)
             {
-                *ptr_buffer |= mask_edge_vert_lower;
-                ptr_buffer++;
+                if (!(flags & I2C_OLED_TEXT_WRAP))
+                {
+                    // Rest of the line is dropped //
+                    
+                    truncated = true;
+                    
+                    ptr_line_end = ptr_scan;
+                    while (*ptr_scan && *ptr_scan != '\n')
+                        ptr_scan++;
+                    ptr_next_line = (*ptr_scan == '\n') ? ptr_scan + 1 : ptr_scan;
+                }
+                else if (current_char == ' ' || ptr_last_space == NULL)
+                {
+                    // Break right here, a word longer than the line is split //
+                    
+                    ptr_line_end = ptr_scan;
+                    ptr_next_line = ptr_scan;
+                }
+                else
+                {
+                    ptr_line_end = ptr_last_space;
+                    ptr_next_line = ptr_last_space + 1;
+                    chars = chars_at_last_space;
+                }
+                
+                if (flags & I2C_OLED_TEXT_WRAP)
+                {
+                    while (ptr_line_end > ptr_str && ptr_line_end[-1] == ' ')
+                    {
+                        ptr_line_end--;
+                        chars--;
+                    }
+                    
+                    while (*ptr_next_line == ' ')
+                        ptr_next_line++;
+                }
+                
+                break;
             }
-        }
-        else
-        {
-            uint8_t mask_edge_vert_upper_inverted = ~mask_edge_vert_upper;
-            uint8_t mask_edge_vert_lower_inverted = ~mask_edge_vert_lower;
             
-            // Upper edge (inverted) //
-            
-            for (int i = start_x; i <= end_x; i++)
+            if (current_char == ' ')
             {
-                *ptr_buffer &= mask_edge_vert_upper_inverted;
-                ptr_buffer++;
+                ptr_last_space = ptr_scan;
+                chars_at_last_space = chars;
             }
             
-            // Lower edge (inverted) //
-            
-            ptr_buffer = &I2C_OLED_buffer[(I2C_OLED_COLUMNS * page_end_y) + start_x];
-            
-            for (int i = start_x; i <= end_x; i++)
-            {
-                *ptr_buffer &= mask_edge_vert_lower_inverted;
-                ptr_buffer++;
-            }
+            chars++;
+            ptr_scan++;
         }
         
-        // Middle //
+        // Ellipsis when the line was cut or text is left after the last line //
         
-        uint8_t page_middle = page_start_y + 1;
+        bool ellipsis = false;
         
-        if (page_middle < page_end_y)
+        if ((flags & I2C_OLED_TEXT_ELLIPSIS) && (truncated || (line == lines_max - 1 && *ptr_next_line)))
         {
-            uint8_t pixels;
-            if (!inverted)
-                pixels = 0xFF;
-            else
-                pixels = 0x00;
+            ellipsis = true;
             
-            for (int i = page_middle; i < page_end_y; i++)
+            if (chars == line_max_chars)
             {
-                ptr_buffer = &I2C_OLED_buffer[(I2C_OLED_COLUMNS * i) + start_x];
+                // Make room for it //
                 
-                for (int j = start_x; j <= end_x; j++)
+                do
                 {
-                    *ptr_buffer = pixels;
-                    ptr_buffer++;
+                    ptr_line_end--;
                 }
+                while (*ptr_line_end == '\r');
+                
+                chars--;
             }
         }
-    }
-    
-    if (!I2C_OLED_manual_update)
-        I2C_OLED_UpdatePartially(start_x, end_x, page_start_y, page_end_y);
-}
-
-void I2C_OLED_GetStrSizeXY(const char *str, int *out_width, int *out_height)
-{
-    char *ptr_str = (char *)str;
-    
-    int text_width = 0;
-    int width_current_line = 0;
-    
-    int text_height = 8;
-    
-    while (*ptr_str)
-    {
-        char current_char = *ptr_str;
-        
-        ptr_str++;
         
-        if (current_char == '\n')
-        {
-            text_height += 8;
-            
-            width_current_line = 0;
-            continue;
-        }
+        // Alignment //
         
-        if (current_char == '\r')
-            continue;
+        int16_t line_width = (chars + (ellipsis ? 1 : 0)) * 6 - 1;
         
-        width_current_line += 6;
+        int16_t line_x = start_x;
         
-        if (width_current_line > text_width)
-            text_width = width_current_line;
-    }
-    
-    if (out_width != NULL)
-        *out_width = text_width;
-    
-    if (out_height != NULL)
-        *out_height = text_height;
-}
-
-void I2C_OLED_PutCharXY
-(
-    char character,
-    int16_t x, int16_t y,
-    bool inverted
-)
-{
-    if (character < 0x20 || character > 0x7F)
-        return;
-    
-    if ((x <= -5 || x >= I2C_OLED_COLUMNS + 5) || (y <= -8 || y >= I2C_OLED_ROWS + 8))
-        return;
-    
-    int16_t page_y = y / 8;
-    
-    uint8_t *ptr_glyph = (uint8_t *)Font_VertHorz_ascii[character - 0x20];
-    
-    int16_t current_x = x;
-    
-    if ((y & 0x07) == 0)
-    {
-        // If y is aligned to page //
+        if (align == I2C_OLED_ALIGN_CENTER)
+            line_x += (box_width - line_width) / 2;
+        else if (align == I2C_OLED_ALIGN_RIGHT)
+            line_x += box_width - line_width;
         
-        if (page_y >= I2C_OLED_PAGES)
-            return;
+        // Draw //
         
-        uint8_t *ptr_buffer = &I2C_OLED_buffer[(I2C_OLED_COLUMNS * page_y) + x];
+        I2C_OLED_Rect box;
         
-        for (int i = 0; i < 5; i++)
+        for (const char *ptr_char = ptr_str; ptr_char < ptr_line_end; ptr_char++)
         {
-            if (current_x >= I2C_OLED_COLUMNS)
-                break;
+            char current_char = *ptr_char;
+            
+            if (current_char == '\r')
+                continue;
             
-            if (current_x >= 0)
+            if ((uint8_t)current_char >= 0x20 && (uint8_t)current_char <= 0x7F)
             {
-                if (!inverted)
-                    *ptr_buffer |= *ptr_glyph;
-                else
-                    *ptr_buffer &= ~(*ptr_glyph);
+                if (I2C_OLED_DrawGlyphXY(Font_VertHorz_ascii[current_char - 0x20], line_x, line_y, inverted, &box))
+                    I2C_OLED_RectUnion(&dirty, &box);
             }
             
-            ptr_buffer++;
-            ptr_glyph++;
-            
-            current_x++;
+            line_x += 6;
         }
         
-        if (!I2C_OLED_manual_update)
-            I2C_OLED_UpdatePartially(x, x + 4, page_y, page_y);
-    }
-    else
-    {
-        // If y is not aligned to page //
-        
-        uint8_t *ptr_buffer_upper = &I2C_OLED_buffer[(I2C_OLED_COLUMNS * page_y) + x];
-        uint8_t *ptr_buffer_lower = ptr_buffer_upper + I2C_OLED_COLUMNS;
-        
-        int16_t y_mod_8 = y & 0x07;
-        int16_t y_shift_lower = 8 - y_mod_8;
-        
-        bool no_upper = y < 0;
-        bool no_lower = page_y >= I2C_OLED_PAGES - 1;
-        
-        for (int i = 0; i < 5; i++)
+        if (ellipsis)
         {
-            if (current_x >= I2C_OLED_COLUMNS)
-                break;
-            
-            if (current_x >= 0)
-            {
-                uint8_t glyph_pixels = *ptr_glyph;
-                
-                if (!no_upper)
-                {
-                    uint8_t glyph_upper = glyph_pixels << y_mod_8;
-                    
-                    if (!inverted)
-                        *ptr_buffer_upper |= glyph_upper;
-                    else
-                        *ptr_buffer_upper &= ~glyph_upper;
-                }
-                
-                if (!no_lower)
-                {
-                    uint8_t glyph_lower = glyph_pixels >> y_shift_lower;
-                    
-                    if (!inverted)
-                        *ptr_buffer_lower |= glyph_lower;
-                    else
-                        *ptr_buffer_lower &= ~glyph_lower;
-                }
-            }
-            
-            ptr_buffer_upper++;
-            ptr_buffer_lower++;
-                
-            ptr_glyph++;
-            
-            current_x++;
+            if (I2C_OLED_DrawGlyphXY(ellipsis_glyph, line_x, line_y, inverted, &box))
+                I2C_OLED_RectUnion(&dirty, &box);
         }
         
-        if (!I2C_OLED_manual_update)
-            I2C_OLED_UpdatePartially(x, x + 4, page_y, page_y + 1);
+        if (truncated)
+            fit = false;
+        
+        ptr_str = ptr_next_line;
+        
+        line_y += 8;
     }
-}
-
-void I2C_OLED_PrintStrXY
-(
-    const char *str,
-    int16_t x, int16_t y,
-    bool inverted
-)
-{
-    if (str == NULL)
-        return;
-    
-    int text_width;
-    
-    I2C_OLED_GetStrSizeXY(str, &text_width, NULL);
     
-    if ((x <= -text_width || x >= I2C_OLED_COLUMNS) || (y <= -8 || y >= I2C_OLED_ROWS + 8))
-        return;
+    I2C_OLED_clip = clip_saved;
     
-    int16_t current_x = x;
-    int16_t current_y = y;
+    if (dirty.start_x <= dirty.end_x)
+        I2C_OLED_MarkDirty(dirty.start_x, dirty.start_y, dirty.end_x, dirty.end_y);
     
-    char *ptr_str = (char *)str;
+    if (out_dirty != NULL)
+        *out_dirty = dirty;
     
-    while (*ptr_str)
-    {
-        char current_char = *ptr_str;
-        
-        ptr_str++;
-        
-        if (current_char == '\n')
-        {
-            current_y += 8;
-            
-            if (current_y >= I2C_OLED_ROWS)
-                break;
-            
-            current_x = x;
-            
-            continue;
-        }
-        
-        I2C_OLED_PutCharXY(current_char, current_x, current_y, inverted);
-        
-        current_x += 6;
-    }
+    return fit && *ptr_str == '\0';
 }
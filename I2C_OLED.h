@@ -5,20 +5,131 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
-#include "stm32f1xx_hal.h"
+// Override to build for another STM32 family or against a host-side HAL stub
+#ifndef I2C_OLED_HAL_HEADER
+#define I2C_OLED_HAL_HEADER     "stm32f1xx_hal.h"
+#endif
+
+#include I2C_OLED_HAL_HEADER
 
 #define I2C_OLED_ADDR           0x78
 
-// 0-127 columns, 0-7 pages, 1 column = 1 byte
-#define I2C_OLED_BUFFER_SIZE    (128 * 8)
+// Visible rows: 64 (128x64) or 32 (128x32, the other half of GDDRAM can be used as a back buffer)
+#ifndef I2C_OLED_PANEL_ROWS
+#define I2C_OLED_PANEL_ROWS     64
+#endif
+
+// 0-127 columns, 0-7 pages (0-3 on 128x32), 1 column = 1 byte
+#define I2C_OLED_BUFFER_SIZE    (128 * I2C_OLED_PAGES)
 
 #define I2C_OLED_TIMEOUT        100
 
 #define I2C_OLED_COLUMNS        128
-#define I2C_OLED_PAGES          8
+#define I2C_OLED_PAGES          (I2C_OLED_PANEL_ROWS / 8)
 #define I2C_OLED_ROWS           (I2C_OLED_PAGES * 8)
 
+// GDDRAM always has 64 rows
+#define I2C_OLED_GDDRAM_PAGES   8
+
+// Control bytes (Co = 1: one byte follows, then another control byte; Co = 0: stream until STOP)
+#define I2C_OLED_CONTROL_COMMAND_STREAM 0x00
+#define I2C_OLED_CONTROL_DATA_STREAM    0x40
+#define I2C_OLED_CONTROL_COMMAND        0x80
+#define I2C_OLED_CONTROL_DATA           0xC0
+
+// Address setup (3 commands) + data stream control byte
+#define I2C_OLED_PACKET_HEADER_SIZE     ((3 * 2) + 1)
+
+// I2C_OLED_FlushStep(): smallest budget that sends data (slave address + header + 1 data byte), and the start line command of a flip
+#define I2C_OLED_FLUSH_STEP_MIN_BUDGET  (1 + I2C_OLED_PACKET_HEADER_SIZE + 1)
+#define I2C_OLED_FLUSH_FLIP_BYTES       3
+
+#define I2C_OLED_CLIP_STACK_DEPTH       4
+
+// Pool size for I2C_OLED_SaveRegion() of any width x height rectangle, worst page alignment
+#define I2C_OLED_REGION_POOL_SIZE(width, height)    ((width) * (((height) + 14) / 8))
+
+// I2C_OLED_PrintLabelXY() cache: entries, and characters per entry (longer labels are not cached)
+#ifndef I2C_OLED_LABEL_CACHE_ENTRIES
+#define I2C_OLED_LABEL_CACHE_ENTRIES    8
+#endif
+#ifndef I2C_OLED_LABEL_CACHE_LENGTH
+#define I2C_OLED_LABEL_CACHE_LENGTH     12
+#endif
+
+// I2C_OLED_PrintTextBox() flags
+#define I2C_OLED_TEXT_WRAP              0x01
+#define I2C_OLED_TEXT_ELLIPSIS          0x02
+
+typedef enum
+{
+    I2C_OLED_DITHER_THRESHOLD,          // Fixed threshold at half gray
+    I2C_OLED_DITHER_BAYER,              // 8x8 ordered dithering
+    I2C_OLED_DITHER_FLOYD_STEINBERG,    // Error diffusion
+} I2C_OLED_DitherMode;
+
+typedef enum
+{
+    I2C_OLED_ROTATION_0,
+    I2C_OLED_ROTATION_90,   // Clockwise, 64x128 logical
+    I2C_OLED_ROTATION_180,
+    I2C_OLED_ROTATION_270,  // Clockwise, 64x128 logical
+} I2C_OLED_Rotation;
+
+typedef enum
+{
+    I2C_OLED_ALIGN_LEFT,
+    I2C_OLED_ALIGN_CENTER,
+    I2C_OLED_ALIGN_RIGHT,
+} I2C_OLED_TextAlign;
+
+typedef enum
+{
+    I2C_OLED_PIXEL_SET,
+    I2C_OLED_PIXEL_CLEAR,
+    I2C_OLED_PIXEL_XOR,
+} I2C_OLED_PixelOp;
+
+typedef struct
+{
+    int16_t x, y;
+} I2C_OLED_Point;
+
+// Absolute logical coordinates, inclusive //
+typedef struct
+{
+    int16_t start_x, start_y;   // (0, 0)-(-1, -1) when empty
+    int16_t end_x, end_y;
+} I2C_OLED_Rect;
+
+// Clip rectangle and origin, absolute logical coordinates //
+typedef struct
+{
+    int16_t start_x, start_y;   // Inclusive, (0, 0)-(-1, -1) when empty
+    int16_t end_x, end_y;
+    int16_t origin_x, origin_y;
+} I2C_OLED_ClipRect;
+
+// Buffer bytes saved by I2C_OLED_SaveRegion(), whole pages, absolute logical coordinates //
+typedef struct
+{
+    uint8_t *pixels;            // NULL when nothing was saved
+    int16_t start_x, end_x;
+    int16_t start_page, end_page;
+} I2C_OLED_Region;
+
+// Command and data segments sent in a single I2C transfer //
+typedef struct
+{
+    uint8_t *buffer;
+    uint16_t capacity;
+    uint16_t length;
+    bool closed;        // A data stream was started, nothing can follow it
+    bool overflow;
+} I2C_OLED_Packet;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -34,12 +145,57 @@ extern "C" {
     
     extern uint8_t I2C_OLED_buffer[];
     
+    // Read only, use I2C_OLED_SetRotation() //
+    extern I2C_OLED_Rotation I2C_OLED_rotation;
+    extern uint8_t I2C_OLED_logical_columns;
+    extern uint8_t I2C_OLED_logical_pages;
+    extern uint8_t I2C_OLED_logical_rows;
+    
+    // Read only, use I2C_OLED_PushClip()/I2C_OLED_PopClip() //
+    extern I2C_OLED_ClipRect I2C_OLED_clip;
+    
+    // Area drawn while manual update was on, sent by I2C_OLED_UpdateDirty() //
+    extern I2C_OLED_Rect I2C_OLED_dirty;
+    
+    // Read only, use I2C_OLED_SetDoubleBuffer() //
+    extern bool I2C_OLED_double_buffer;
+    
     extern void I2C_OLED_Initialize(I2C_HandleTypeDef *i2c_handler);
     
+    // Display and charge pump off/on, GDDRAM is kept. Resume re-initializes and resends the buffer if it was not. //
+    extern void I2C_OLED_Sleep(void);
+    extern void I2C_OLED_Resume(bool ram_retained);
+    
+    /*
+        Drawing functions and UpdatePartially() use logical coordinates,
+        direct draw functions don't. Pushed clips stay pushed, trimmed to
+        the new logical size (a clip trimmed at 90/270 does not grow back
+        at 0/180), the unclipped level becomes the whole new screen.
+    */
+    extern void I2C_OLED_SetRotation(I2C_OLED_Rotation rotation);
+    
+    /*
+        128x32 only: the buffer is written to the hidden half of GDDRAM and
+        shown with a single start line command, so a frame never tears.
+        Drawing is always accumulated as with manual update. I2C_OLED_Update(),
+        I2C_OLED_UpdateDirty() and a finished flush present the frame,
+        I2C_OLED_UpdatePartially() only writes the hidden half.
+        Direct draw functions still address GDDRAM pages 0-3.
+    */
+    extern bool I2C_OLED_SetDoubleBuffer(bool enabled);
+    
     extern void I2C_OLED_SetColumnPage(uint8_t column, uint8_t page);
     extern void I2C_OLED_SetCursor(uint8_t column, uint8_t page);
     
     extern void I2C_OLED_WriteToRAM(const uint8_t *buffer, uint16_t count);
+    extern void I2C_OLED_WriteToRAMAt(uint8_t column, uint8_t page, const uint8_t *buffer, uint16_t count);
+    
+    extern void I2C_OLED_Packet_Begin(I2C_OLED_Packet *packet, uint8_t *buffer, uint16_t capacity);
+    extern bool I2C_OLED_Packet_AddCommands(I2C_OLED_Packet *packet, const uint8_t *commands, uint16_t count);
+    extern bool I2C_OLED_Packet_AddColumnPage(I2C_OLED_Packet *packet, uint8_t column, uint8_t page);
+    extern bool I2C_OLED_Packet_AddData(I2C_OLED_Packet *packet, const uint8_t *data, uint16_t count);
+    extern bool I2C_OLED_Packet_AddDataStream(I2C_OLED_Packet *packet, const uint8_t *data, uint16_t count);
+    extern void I2C_OLED_Packet_Send(I2C_OLED_Packet *packet);
     
     extern void I2C_OLED_Update(void);
     extern void I2C_OLED_UpdatePartially
@@ -48,6 +204,30 @@ extern "C" {
         uint8_t start_page,   uint8_t end_page
     );
     
+    /*
+        Time-sliced flush, call I2C_OLED_FlushStep() until it returns true.
+        Budget is in bytes on the wire, including the flip of double
+        buffering. A budget below I2C_OLED_FLUSH_STEP_MIN_BUDGET sends no
+        data, only a deferred flip once the budget has room for it.
+    */
+    extern void I2C_OLED_FlushBegin(void);
+    extern void I2C_OLED_FlushBeginPartially
+    (
+        uint8_t start_column, uint8_t end_column,
+        uint8_t start_page,   uint8_t end_page
+    );
+    extern void I2C_OLED_FlushRestart(void);
+    extern bool I2C_OLED_FlushStep(uint16_t byte_budget);
+    extern bool I2C_OLED_FlushBusy(void);
+    extern void I2C_OLED_FlushGetProgress(uint16_t *out_sent, uint16_t *out_total);
+    
+    extern void I2C_OLED_MarkDirty
+    (
+        int16_t start_x, int16_t start_y,
+        int16_t end_x, int16_t end_y
+    );
+    extern void I2C_OLED_UpdateDirty(void);
+    
     extern void I2C_OLED_ClearDirect(void);
     extern void I2C_OLED_ClearBuffer(void); 
     extern void I2C_OLED_ClearBufferAndUpdate(void);
@@ -60,6 +240,15 @@ extern "C" {
     
     // Note: Functions below can only write to buffer. //
     
+    // Drawing functions below and PutChar() are trimmed to the clip rectangle, XY coordinates are relative to its origin. //
+    extern bool I2C_OLED_PushClip
+    (
+        int16_t start_x, int16_t start_y,
+        int16_t end_x, int16_t end_y
+    );
+    extern void I2C_OLED_PopClip(void);
+    extern void I2C_OLED_ResetClip(void);
+    
     extern void I2C_OLED_DrawRect
     (
         int16_t start_x, int16_t start_y,
@@ -73,6 +262,16 @@ extern "C" {
         bool inverted
     );
     
+    // Pixels: 8-bit grayscale, row-major, width bytes per row. //
+    extern void I2C_OLED_DrawGrayscale
+    (
+        const uint8_t *pixels,
+        int16_t x, int16_t y,
+        int16_t width, int16_t height,
+        I2C_OLED_DitherMode dither_mode,
+        bool inverted
+    );
+    
     extern void I2C_OLED_GetStrSizeXY(const char *str, int *out_width, int *out_height);
     
     extern void I2C_OLED_PutCharXY
@@ -81,6 +280,13 @@ extern "C" {
         int16_t x, int16_t y,
         bool inverted
     );
+    // Replaces the whole 6x8 character cell instead of only setting (clearing) glyph pixels //
+    extern void I2C_OLED_PutCharOpaqueXY
+    (
+        char character,
+        int16_t x, int16_t y,
+        bool inverted
+    );
     extern void I2C_OLED_PrintStrXY
     (
         const char *str,
@@ -88,6 +294,106 @@ extern "C" {
         bool inverted
     );
     
+    /*
+        Lays text out inside a box (relative coordinates, inclusive) in one pass.
+        Lines wider than the box are wrapped at spaces with I2C_OLED_TEXT_WRAP,
+        otherwise cut. I2C_OLED_TEXT_ELLIPSIS marks cut lines and text left
+        over below the box. Returns true when all of the text was placed,
+        out_dirty (may be NULL) gets the absolute area that was drawn.
+    */
+    extern bool I2C_OLED_PrintTextBox
+    (
+        const char *str,
+        int16_t start_x, int16_t start_y,
+        int16_t end_x, int16_t end_y,
+        I2C_OLED_TextAlign align,
+        uint8_t flags,
+        bool inverted,
+        I2C_OLED_Rect *out_dirty
+    );
+    
+    /*
+        Copies the pages under a rectangle (relative, trimmed to the clip rectangle) into pool,
+        false if it does not fit. Restore writes them back and marks only that area dirty,
+        rows of those pages outside the rectangle are restored too.
+    */
+    extern bool I2C_OLED_SaveRegion
+    (
+        I2C_OLED_Region *region,
+        int16_t start_x, int16_t start_y,
+        int16_t end_x, int16_t end_y,
+        uint8_t *pool, uint16_t pool_size
+    );
+    extern void I2C_OLED_RestoreRegion(I2C_OLED_Region *region);
+    
+    // Like PrintStrXY() for single-line labels drawn every frame, rendered glyphs are cached per y mod 8. //
+    extern void I2C_OLED_PrintLabelXY
+    (
+        const char *str,
+        int16_t x, int16_t y,
+        bool inverted
+    );
+    extern void I2C_OLED_ResetLabelCache(void);
+    extern void I2C_OLED_GetLabelCacheStatistics(uint32_t *out_hits, uint32_t *out_misses);
+    
+    // Points are reordered (sorted by buffer byte), each byte is written once, one dirty box for all. //
+    extern void I2C_OLED_PlotPoints(I2C_OLED_Point *points, uint16_t count, I2C_OLED_PixelOp op);
+    
+    /*
+        Single pixels: clip rectangle and origin apply like everywhere else,
+        but nothing is marked dirty, call I2C_OLED_MarkDirty() when done.
+    */
+    
+    // Buffer byte of a pixel, NULL when clipped //
+    static inline uint8_t *I2C_OLED_PixelByte(int16_t x, int16_t y, uint8_t *out_bit)
+    {
+        x += I2C_OLED_clip.origin_x;
+        y += I2C_OLED_clip.origin_y;
+        
+        if (x < I2C_OLED_clip.start_x || x > I2C_OLED_clip.end_x || y < I2C_OLED_clip.start_y || y > I2C_OLED_clip.end_y)
+            return NULL;
+        
+        *out_bit = 1 << (y & 0x07);
+        
+        return &I2C_OLED_buffer[((y >> 3) * I2C_OLED_logical_columns) + x];
+    }
+    
+    static inline void I2C_OLED_SetPixel(int16_t x, int16_t y)
+    {
+        uint8_t bit;
+        uint8_t *ptr_buffer = I2C_OLED_PixelByte(x, y, &bit);
+        
+        if (ptr_buffer != NULL)
+            *ptr_buffer |= bit;
+    }
+    
+    static inline void I2C_OLED_ClearPixel(int16_t x, int16_t y)
+    {
+        uint8_t bit;
+        uint8_t *ptr_buffer = I2C_OLED_PixelByte(x, y, &bit);
+        
+        if (ptr_buffer != NULL)
+            *ptr_buffer &= ~bit;
+    }
+    
+    static inline void I2C_OLED_XorPixel(int16_t x, int16_t y)
+    {
+        uint8_t bit;
+        uint8_t *ptr_buffer = I2C_OLED_PixelByte(x, y, &bit);
+        
+        if (ptr_buffer != NULL)
+            *ptr_buffer ^= bit;
+    }
+    
+    // Clipped pixels read as off //
+    static inline bool I2C_OLED_GetPixel(int16_t x, int16_t y)
+    {
+        uint8_t bit;
+        uint8_t *ptr_buffer = I2C_OLED_PixelByte(x, y, &bit);
+        
+        return ptr_buffer != NULL && (*ptr_buffer & bit) != 0;
+    }
+    
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef __I2C_OLED_ATOMIC_H__
+#define __I2C_OLED_ATOMIC_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+    32-bit atomics used by the display service queue.
+    
+    GCC/Clang: __atomic builtins (LDREX/STREX on Cortex-M3, native on hosts).
+    Other compilers: single-core fallback with short PRIMASK critical
+    sections, needs the CMSIS core functions from the HAL header.
+*/
+
+#if defined(__GNUC__) || defined(__clang__)
+
+static inline uint32_t I2C_OLED_Atomic_Load(volatile uint32_t *ptr)
+{
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+static inline void I2C_OLED_Atomic_Store(volatile uint32_t *ptr, uint32_t value)
+{
+    __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+// On failure *expected receives the current value //
+static inline bool I2C_OLED_Atomic_CompareExchange(volatile uint32_t *ptr, uint32_t *expected, uint32_t desired)
+{
+    return __atomic_compare_exchange_n(ptr, expected, desired, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+static inline uint32_t I2C_OLED_Atomic_FetchAdd(volatile uint32_t *ptr, uint32_t value)
+{
+    return __atomic_fetch_add(ptr, value, __ATOMIC_RELAXED);
+}
+
+#else
+
+#include "I2C_OLED.h"
+
+#include I2C_OLED_HAL_HEADER
+
+static inline uint32_t I2C_OLED_Atomic_Load(volatile uint32_t *ptr)
+{
+    uint32_t value = *ptr;
+    __DMB();
+    return value;
+}
+
+static inline void I2C_OLED_Atomic_Store(volatile uint32_t *ptr, uint32_t value)
+{
+    __DMB();
+    *ptr = value;
+}
+
+static inline bool I2C_OLED_Atomic_CompareExchange(volatile uint32_t *ptr, uint32_t *expected, uint32_t desired)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    
+    uint32_t current = *ptr;
+    bool exchanged = current == *expected;
+    
+    if (exchanged)
+        *ptr = desired;
+    else
+        *expected = current;
+    
+    __set_PRIMASK(primask);
+    
+    return exchanged;
+}
+
+static inline uint32_t I2C_OLED_Atomic_FetchAdd(volatile uint32_t *ptr, uint32_t value)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    
+    uint32_t previous = *ptr;
+    *ptr = previous + value;
+    
+    __set_PRIMASK(primask);
+    
+    return previous;
+}
+
+#endif
+
+#endif
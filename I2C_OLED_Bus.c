@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "I2C_OLED_Bus.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "I2C_OLED.h"
+#include "I2C_OLED_Atomic.h"
+
+#include I2C_OLED_HAL_HEADER
+
+/*
+    Requests are kept in a list sorted by priority, registration order
+    within one priority. Each poll walks it from the front and runs a
+    single transfer of the first pending request, a request that needs
+    more transfers stays pending and is looked at again on the next poll.
+*/
+
+static I2C_OLED_BusRequest *request_list = NULL;
+
+void I2C_OLED_Bus_Register
+(
+    I2C_OLED_BusRequest *request,
+    bool (*transfer)(void *argument),
+    void *argument,
+    I2C_OLED_BusPriority priority
+)
+{
+    if (request == NULL || transfer == NULL)
+        return;
+    
+    // Registering again moves the request //
+    
+    for (I2C_OLED_BusRequest **ptr_link = &request_list; *ptr_link != NULL; ptr_link = &(*ptr_link)->next)
+    {
+        if (*ptr_link == request)
+        {
+            *ptr_link = request->next;
+            break;
+        }
+    }
+    
+    request->transfer = transfer;
+    request->argument = argument;
+    request->priority = priority;
+    request->completed = 0;
+    I2C_OLED_Atomic_Store(&request->submitted, 0);
+    
+    I2C_OLED_BusRequest **ptr_link = &request_list;
+    
+    while (*ptr_link != NULL && (*ptr_link)->priority <= priority)
+        ptr_link = &(*ptr_link)->next;
+    
+    request->next = *ptr_link;
+    *ptr_link = request;
+}
+
+void I2C_OLED_Bus_Submit(I2C_OLED_BusRequest *request)
+{
+    if (request == NULL)
+        return;
+    
+    I2C_OLED_Atomic_FetchAdd(&request->submitted, 1);
+}
+
+bool I2C_OLED_Bus_IsPending(I2C_OLED_BusRequest *request)
+{
+    if (request == NULL)
+        return false;
+    
+    return I2C_OLED_Atomic_Load(&request->submitted) != request->completed;
+}
+
+bool I2C_OLED_Bus_Poll(void)
+{
+    // An interrupt or DMA transfer of another driver is still running //
+    
+    bool bus_ready = I2C_OLED_i2c_handler == NULL || HAL_I2C_GetState(I2C_OLED_i2c_handler) == HAL_I2C_STATE_READY;
+    
+    for (I2C_OLED_BusRequest *request = request_list; request != NULL && bus_ready; request = request->next)
+    {
+        uint32_t submitted = I2C_OLED_Atomic_Load(&request->submitted);
+        
+        if (submitted == request->completed)
+            continue;
+        
+        if (request->transfer(request->argument))
+            request->completed = submitted;
+        
+        break;
+    }
+    
+    for (I2C_OLED_BusRequest *request = request_list; request != NULL; request = request->next)
+    {
+        if (I2C_OLED_Bus_IsPending(request))
+            return true;
+    }
+    
+    return false;
+}
+
+// Display //
+
+static I2C_OLED_BusRequest display_request;
+static uint16_t display_chunk_bytes = I2C_OLED_BUS_DISPLAY_CHUNK;
+
+static bool I2C_OLED_Bus_DisplayTransfer(void *argument)
+{
+    (void)argument;
+    
+    if (!I2C_OLED_FlushBusy())
+    {
+        // Takes whatever is dirty by the time the bus is free //
+        
+        if (I2C_OLED_dirty.start_x > I2C_OLED_dirty.end_x)
+            return true;
+        
+        I2C_OLED_FlushBeginPartially(I2C_OLED_dirty.start_x, I2C_OLED_dirty.end_x, I2C_OLED_dirty.start_y / 8, I2C_OLED_dirty.end_y / 8);
+        
+        I2C_OLED_dirty.start_x = 0;
+        I2C_OLED_dirty.start_y = 0;
+        I2C_OLED_dirty.end_x = -1;
+        I2C_OLED_dirty.end_y = -1;
+    }
+    
+    if (!I2C_OLED_FlushStep(display_chunk_bytes))
+        return false;
+    
+    // Drawn while the flush ran, stay pending so the next poll starts on it //
+    
+    return I2C_OLED_dirty.start_x > I2C_OLED_dirty.end_x;
+}
+
+void I2C_OLED_Bus_RegisterDisplay(I2C_OLED_BusPriority priority, uint16_t chunk_bytes)
+{
+    // Smaller chunks would never send anything //
+    
+    if (chunk_bytes < I2C_OLED_FLUSH_STEP_MIN_BUDGET)
+        chunk_bytes = I2C_OLED_FLUSH_STEP_MIN_BUDGET;
+    
+    display_chunk_bytes = chunk_bytes;
+    
+    I2C_OLED_Bus_Register(&display_request, I2C_OLED_Bus_DisplayTransfer, NULL, priority);
+}
+
+void I2C_OLED_Bus_SubmitDisplay(void)
+{
+    if (display_request.transfer == NULL)
+        I2C_OLED_Bus_RegisterDisplay(I2C_OLED_BUS_PRIORITY_LOW, I2C_OLED_BUS_DISPLAY_CHUNK);
+    
+    // One submission is enough, the request stays pending until nothing is dirty //
+    
+    if (!I2C_OLED_Bus_IsPending(&display_request))
+        I2C_OLED_Bus_Submit(&display_request);
+}
@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef __I2C_OLED_BUS_H__
+#define __I2C_OLED_BUS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Display chunk size on the wire, about 1 ms at 400 kHz //
+#define I2C_OLED_BUS_DISPLAY_CHUNK      40
+
+typedef enum
+{
+    I2C_OLED_BUS_PRIORITY_HIGH,     // e.g. IMU sample reads
+    I2C_OLED_BUS_PRIORITY_NORMAL,
+    I2C_OLED_BUS_PRIORITY_LOW,      // e.g. display flush, EEPROM writes
+} I2C_OLED_BusPriority;
+
+typedef struct I2C_OLED_BusRequest
+{
+    // Runs one bounded transaction, returns true once the request is complete //
+    bool (*transfer)(void *argument);
+    void *argument;
+    
+    uint8_t priority;
+    
+    // Pending while submitted != completed, so a submit during the last transfer is not lost //
+    volatile uint32_t submitted;
+    uint32_t completed;
+    
+    struct I2C_OLED_BusRequest *next;
+} I2C_OLED_BusRequest;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    
+    /*
+        Bus arbiter: every driver on the bus registers a request and does
+        its transfers only from it. I2C_OLED_Bus_Poll() runs one transfer
+        of the highest priority pending request, so a long display flush
+        gives way to sensor reads between chunks.
+        
+        Register and Poll from the main loop, Submit from anywhere (ISR too).
+    */
+    
+    extern void I2C_OLED_Bus_Register
+    (
+        I2C_OLED_BusRequest *request,
+        bool (*transfer)(void *argument),
+        void *argument,
+        I2C_OLED_BusPriority priority
+    );
+    
+    extern void I2C_OLED_Bus_Submit(I2C_OLED_BusRequest *request);
+    extern bool I2C_OLED_Bus_IsPending(I2C_OLED_BusRequest *request);
+    
+    // Returns true while requests are still pending. Does nothing while the HAL reports the bus busy. //
+    extern bool I2C_OLED_Bus_Poll(void);
+    
+    /*
+        Display: sends the dirty area in chunks of chunk_bytes (see
+        I2C_OLED_FlushStep()), at least I2C_OLED_FLUSH_STEP_MIN_BUDGET.
+        Drawing done while a flush runs is sent by a further flush before
+        the request completes, no second I2C_OLED_Bus_SubmitDisplay() is
+        needed. Keep manual update on, otherwise drawing goes to the bus
+        right away.
+    */
+    extern void I2C_OLED_Bus_RegisterDisplay(I2C_OLED_BusPriority priority, uint16_t chunk_bytes);
+    extern void I2C_OLED_Bus_SubmitDisplay(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
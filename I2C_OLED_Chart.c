@@ -0,0 +1,374 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "I2C_OLED_Chart.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "I2C_OLED.h"
+#include "I2C_OLED_Trace.h"
+
+#include I2C_OLED_HAL_HEADER
+
+/*
+    Each committed column shifts the chart area left by one column in
+    I2C_OLED_buffer (memmove for whole pages, masked copy for pages the
+    chart only partly covers) and renders only the new rightmost column.
+*/
+
+static int16_t I2C_OLED_Chart_ValueToRow(I2C_OLED_Chart *chart, int16_t value)
+{
+    if (value <= chart->min_value)
+        return chart->end_y;
+    if (value >= chart->max_value)
+        return chart->start_y;
+    
+    int32_t height = chart->end_y - chart->start_y;
+    int32_t range = (int32_t)chart->max_value - chart->min_value;
+    
+    return chart->end_y - (int16_t)((((int32_t)value - chart->min_value) * height + (range / 2)) / range);
+}
+
+// Rows of the chart inside a page //
+
+static uint8_t I2C_OLED_Chart_PageMask(I2C_OLED_Chart *chart, int16_t page)
+{
+    int16_t row_first = page * 8;
+    int16_t row_last = row_first + 7;
+    
+    uint8_t mask = 0xFF;
+    
+    if (row_first < chart->start_y)
+        mask &= 0xFF << (chart->start_y - row_first);
+    if (row_last > chart->end_y)
+        mask &= 0xFF >> (row_last - chart->end_y);
+    
+    return mask;
+}
+
+// Replaces one column of the chart with a vertical span from row_top to row_bottom //
+
+static void I2C_OLED_Chart_RenderColumn(I2C_OLED_Chart *chart, int16_t x, int16_t row_top, int16_t row_bottom)
+{
+    if (row_top > row_bottom)
+    {
+        int16_t temp = row_top;
+        row_top = row_bottom;
+        row_bottom = temp;
+    }
+    
+    uint8_t *ptr_buffer = &I2C_OLED_buffer[((chart->start_y / 8) * I2C_OLED_logical_columns) + x];
+    
+    for (int page = chart->start_y / 8; page <= chart->end_y / 8; page++)
+    {
+        int16_t row_first = page * 8;
+        
+        uint8_t mask = I2C_OLED_Chart_PageMask(chart, page);
+        uint8_t pixels = 0x00;
+        
+        if (row_top <= row_first + 7 && row_bottom >= row_first)
+        {
+            pixels = 0xFF;
+            if (row_top > row_first)
+                pixels &= 0xFF << (row_top - row_first);
+            if (row_bottom < row_first + 7)
+                pixels &= 0xFF >> (row_first + 7 - row_bottom);
+        }
+        
+        *ptr_buffer = (*ptr_buffer & ~mask) | (pixels & mask);
+        
+        ptr_buffer += I2C_OLED_logical_columns;
+    }
+}
+
+static void I2C_OLED_Chart_RenderEntry(I2C_OLED_Chart *chart, int16_t x, uint8_t index, bool has_previous, int16_t value_previous)
+{
+    int16_t row_top = I2C_OLED_Chart_ValueToRow(chart, chart->column_max[index]);
+    int16_t row_bottom = I2C_OLED_Chart_ValueToRow(chart, chart->column_min[index]);
+    
+    if (chart->mode == I2C_OLED_CHART_LINE && has_previous)
+    {
+        // Join with the previous column, stopping halfway would leave gaps on steep edges //
+        
+        int16_t row_previous = I2C_OLED_Chart_ValueToRow(chart, value_previous);
+        
+        if (row_previous < row_top)
+            row_top = row_previous + 1;
+        else if (row_previous > row_bottom)
+            row_bottom = row_previous - 1;
+        
+        if (row_top > row_bottom)
+            row_top = row_bottom;
+    }
+    
+    I2C_OLED_Chart_RenderColumn(chart, x, row_top, row_bottom);
+}
+
+static void I2C_OLED_Chart_ShiftLeft(I2C_OLED_Chart *chart)
+{
+    int16_t columns = chart->end_x - chart->start_x;
+    
+    if (columns <= 0)
+        return;
+    
+    for (int page = chart->start_y / 8; page <= chart->end_y / 8; page++)
+    {
+        uint8_t *ptr_buffer = &I2C_OLED_buffer[(page * I2C_OLED_logical_columns) + chart->start_x];
+        uint8_t mask = I2C_OLED_Chart_PageMask(chart, page);
+        
+        if (mask == 0xFF)
+        {
+            memmove(ptr_buffer, ptr_buffer + 1, columns);
+        }
+        else
+        {
+            uint8_t mask_inverted = ~mask;
+            
+            for (int i = 0; i < columns; i++)
+            {
+                *ptr_buffer = (*ptr_buffer & mask_inverted) | (ptr_buffer[1] & mask);
+                ptr_buffer++;
+            }
+        }
+    }
+}
+
+/*
+    Content scroll (2Dh, left by one column) over the chart pages, then the
+    new column is written. Needs the one-column content scroll of SSD1306
+    datasheet rev 1.5 and later. A second 2Dh within 2 frames corrupts
+    GDDRAM, AddSample() checks I2C_OLED_Chart_ScrollAllowed() first.
+*/
+
+static bool I2C_OLED_Chart_ScrollAllowed(I2C_OLED_Chart *chart)
+{
+    return HAL_GetTick() - chart->scroll_tick >= I2C_OLED_CHART_SCROLL_INTERVAL;
+}
+
+static void I2C_OLED_Chart_ScrollHardware(I2C_OLED_Chart *chart)
+{
+    uint8_t scroll_commands[] =
+    {
+        0x2D,                       // Left horizontal scroll by one column
+        0x00,                       // Dummy
+        chart->start_y / 8,         // Start page
+        0x01,                       // Dummy
+        chart->end_y / 8,           // End page
+        0x00,                       // Dummy
+        chart->start_x,             // Start column
+        chart->end_x,               // End column
+    };
+    
+    I2C_OLED_TRACE_WRITE(0x00, scroll_commands, sizeof(scroll_commands));
+    
+    HAL_I2C_Mem_Write
+    (
+        I2C_OLED_i2c_handler,
+        I2C_OLED_ADDR,
+        0x00,
+        1,
+        scroll_commands,
+        sizeof(scroll_commands),
+        I2C_OLED_TIMEOUT
+    );
+    
+    chart->scroll_tick = HAL_GetTick();
+    
+    I2C_OLED_UpdatePartially(chart->end_x, chart->end_x, chart->start_y / 8, chart->end_y / 8);
+}
+
+void I2C_OLED_Chart_Clear(I2C_OLED_Chart *chart)
+{
+    if (chart == NULL)
+        return;
+    
+    chart->head = 0;
+    chart->count = 0;
+    chart->has_evicted = false;
+    chart->pending_samples = 0;
+    
+    I2C_OLED_Chart_Redraw(chart);
+}
+
+void I2C_OLED_Chart_Initialize
+(
+    I2C_OLED_Chart *chart,
+    int16_t start_x, int16_t start_y,
+    int16_t end_x, int16_t end_y,
+    int16_t min_value, int16_t max_value,
+    I2C_OLED_ChartMode mode,
+    uint8_t samples_per_column
+)
+{
+    if (chart == NULL)
+        return;
+    
+    if (start_x > end_x)
+    {
+        int16_t temp = start_x;
+        start_x = end_x;
+        end_x = temp;
+    }
+    if (start_y > end_y)
+    {
+        int16_t temp = start_y;
+        start_y = end_y;
+        end_y = temp;
+    }
+    if (min_value > max_value)
+    {
+        int16_t temp = min_value;
+        min_value = max_value;
+        max_value = temp;
+    }
+    
+    if (start_x < 0)
+        start_x = 0;
+    if (end_x >= I2C_OLED_logical_columns)
+        end_x = I2C_OLED_logical_columns - 1;
+    if (start_y < 0)
+        start_y = 0;
+    if (end_y >= I2C_OLED_logical_rows)
+        end_y = I2C_OLED_logical_rows - 1;
+    
+    if (samples_per_column == 0)
+        samples_per_column = 1;
+    
+    chart->start_x = start_x;
+    chart->start_y = start_y;
+    chart->end_x = end_x;
+    chart->end_y = end_y;
+    
+    chart->min_value = min_value;
+    chart->max_value = max_value;
+    
+    chart->mode = mode;
+    chart->samples_per_column = samples_per_column;
+    
+    chart->hardware_scroll = false;
+    
+    I2C_OLED_Chart_Clear(chart);
+}
+
+bool I2C_OLED_Chart_SetHardwareScroll(I2C_OLED_Chart *chart, bool enabled)
+{
+    if (chart == NULL)
+        return false;
+    
+    chart->hardware_scroll = false;
+    
+    if (!enabled)
+        return true;
+    
+    if (I2C_OLED_rotation != I2C_OLED_ROTATION_0 || I2C_OLED_double_buffer)
+        return false;
+    
+    if (chart->start_x != 0 || chart->end_x != I2C_OLED_COLUMNS - 1)
+        return false;
+    
+    if ((chart->start_y & 0x07) != 0 || (chart->end_y & 0x07) != 0x07)
+        return false;
+    
+    // The first step may go out right away //
+    
+    chart->scroll_tick = HAL_GetTick() - I2C_OLED_CHART_SCROLL_INTERVAL;
+    chart->hardware_scroll = true;
+    
+    return true;
+}
+
+void I2C_OLED_Chart_AddSample(I2C_OLED_Chart *chart, int16_t value)
+{
+    if (chart == NULL || chart->start_x > chart->end_x || chart->start_y > chart->end_y)
+        return;
+    
+    if (chart->pending_samples == 0)
+    {
+        chart->pending_min = value;
+        chart->pending_max = value;
+    }
+    else
+    {
+        if (value < chart->pending_min)
+            chart->pending_min = value;
+        if (value > chart->pending_max)
+            chart->pending_max = value;
+    }
+    
+    chart->pending_samples++;
+    
+    if (chart->pending_samples < chart->samples_per_column)
+        return;
+    
+    chart->pending_samples = 0;
+    
+    // Commit the column //
+    
+    uint8_t width = chart->end_x - chart->start_x + 1;
+    
+    bool has_previous = chart->count > 0;
+    int16_t value_previous = chart->column_max[(chart->head + chart->count + width - 1) % width];
+    uint8_t index;
+    
+    if (chart->count < width)
+    {
+        index = (chart->head + chart->count) % width;
+        chart->count++;
+    }
+    else
+    {
+        index = chart->head;
+        chart->head = (chart->head + 1) % width;
+        
+        chart->evicted_max = chart->column_max[index];
+        chart->has_evicted = true;
+    }
+    
+    chart->column_min[index] = chart->pending_min;
+    chart->column_max[index] = chart->pending_max;
+    
+    I2C_OLED_Chart_ShiftLeft(chart);
+    I2C_OLED_Chart_RenderEntry(chart, chart->end_x, index, has_previous, value_previous);
+    
+    // Too soon after the last scroll command: the whole area is sent instead //
+    
+    if (chart->hardware_scroll && !I2C_OLED_manual_update && I2C_OLED_Chart_ScrollAllowed(chart))
+        I2C_OLED_Chart_ScrollHardware(chart);
+    else
+        I2C_OLED_MarkDirty(chart->start_x, chart->start_y, chart->end_x, chart->end_y);
+}
+
+void I2C_OLED_Chart_Redraw(I2C_OLED_Chart *chart)
+{
+    if (chart == NULL || chart->start_x > chart->end_x || chart->start_y > chart->end_y)
+        return;
+    
+    uint8_t width = chart->end_x - chart->start_x + 1;
+    
+    // Empty columns on the left until the chart has filled up //
+    
+    int16_t x = chart->start_x;
+    
+    for (int i = chart->count; i < width; i++)
+    {
+        I2C_OLED_Chart_RenderColumn(chart, x, chart->end_y + 1, chart->end_y + 1);
+        x++;
+    }
+    
+    bool has_previous = chart->has_evicted;
+    int16_t value_previous = chart->evicted_max;
+    
+    for (int i = 0; i < chart->count; i++)
+    {
+        uint8_t index = (chart->head + i) % width;
+        
+        I2C_OLED_Chart_RenderEntry(chart, x, index, has_previous, value_previous);
+        
+        has_previous = true;
+        value_previous = chart->column_max[index];
+        x++;
+    }
+    
+    I2C_OLED_MarkDirty(chart->start_x, chart->start_y, chart->end_x, chart->end_y);
+}
@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef __I2C_OLED_CHART_H__
+#define __I2C_OLED_CHART_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "I2C_OLED.h"
+
+#define I2C_OLED_CHART_MAX_COLUMNS  I2C_OLED_COLUMNS
+
+/*
+    Minimum time between two hardware scroll steps (ms): 2 frame periods.
+    With the initialization settings (D5h 0x80, D9h 0xF1) a frame is 66
+    DCLKs per row, at the slowest oscillator (333 kHz) about 12.7 ms on
+    128x64 and half that on 128x32. One tick is added for HAL_GetTick()
+    granularity.
+*/
+#ifndef I2C_OLED_CHART_SCROLL_INTERVAL
+#define I2C_OLED_CHART_SCROLL_INTERVAL  ((I2C_OLED_PANEL_ROWS == 32) ? 14 : 27)
+#endif
+
+typedef enum
+{
+    I2C_OLED_CHART_LINE,    // Connects each column to the previous one
+    I2C_OLED_CHART_MINMAX,  // Min-max span of the samples in each column
+} I2C_OLED_ChartMode;
+
+typedef struct
+{
+    // Chart area, absolute logical coordinates, not affected by the clip rectangle //
+    
+    int16_t start_x, start_y;
+    int16_t end_x, end_y;
+    
+    int16_t min_value, max_value;
+    
+    I2C_OLED_ChartMode mode;
+    uint8_t samples_per_column;
+    
+    bool hardware_scroll;
+    uint32_t scroll_tick;       // HAL_GetTick() of the last scroll command
+    
+    // Ring of committed columns, oldest at head //
+    
+    int16_t column_min[I2C_OLED_CHART_MAX_COLUMNS];
+    int16_t column_max[I2C_OLED_CHART_MAX_COLUMNS];
+    uint8_t head;
+    uint8_t count;
+    
+    // Last column scrolled out, the leftmost line segment joins to it //
+    
+    int16_t evicted_max;
+    bool has_evicted;
+    
+    // Column being accumulated //
+    
+    int16_t pending_min, pending_max;
+    uint8_t pending_samples;
+} I2C_OLED_Chart;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    
+    extern void I2C_OLED_Chart_Initialize
+    (
+        I2C_OLED_Chart *chart,
+        int16_t start_x, int16_t start_y,
+        int16_t end_x, int16_t end_y,
+        int16_t min_value, int16_t max_value,
+        I2C_OLED_ChartMode mode,
+        uint8_t samples_per_column
+    );
+    
+    /*
+        Only when the chart spans the full width, full pages and rotation is 0.
+        The controller needs 2 frame periods between scroll commands
+        (I2C_OLED_CHART_SCROLL_INTERVAL), a column committed sooner is sent
+        the software way: the whole chart area is written again.
+    */
+    extern bool I2C_OLED_Chart_SetHardwareScroll(I2C_OLED_Chart *chart, bool enabled);
+    
+    extern void I2C_OLED_Chart_AddSample(I2C_OLED_Chart *chart, int16_t value);
+    
+    extern void I2C_OLED_Chart_Clear(I2C_OLED_Chart *chart);
+    extern void I2C_OLED_Chart_Redraw(I2C_OLED_Chart *chart);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,183 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "I2C_OLED_FramePacer.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "I2C_OLED.h"
+
+#include I2C_OLED_HAL_HEADER
+
+/*
+    Frames are presented on a fixed grid of 1000 / target_fps ms.
+    Only the newest submitted frame is kept: a frame submitted while
+    another one is still waiting replaces it and counts as dropped.
+    A flush that overruns its slot skips the missed slots instead of
+    trying to catch up with a burst, so latency stays bounded to about
+    one flush.
+    
+    Without a flush function the frame is sent with I2C_OLED_FlushStep(),
+    one step per poll, so the main loop keeps running while it is on the
+    bus. Frames submitted meanwhile wait, and all but the newest drop.
+*/
+
+void I2C_OLED_FramePacer_SetTargetFPS(I2C_OLED_FramePacer *pacer, uint16_t target_fps)
+{
+    if (pacer == NULL)
+        return;
+    
+    if (target_fps == 0)
+        target_fps = 1;
+    
+    pacer->target_fps = target_fps;
+    pacer->frame_interval = 1000 / target_fps;
+    pacer->interval_remainder = 1000 % target_fps;
+    pacer->remainder_accumulator = 0;
+}
+
+void I2C_OLED_FramePacer_ResetStatistics(I2C_OLED_FramePacer *pacer)
+{
+    if (pacer == NULL)
+        return;
+    
+    pacer->fps_window_start = pacer->get_tick();
+    pacer->fps_window_frames = 0;
+    
+    pacer->achieved_fps = 0;
+    pacer->frames_presented = 0;
+    pacer->frames_dropped = 0;
+    pacer->last_flush_duration = 0;
+}
+
+void I2C_OLED_FramePacer_Initialize
+(
+    I2C_OLED_FramePacer *pacer,
+    uint16_t target_fps,
+    uint32_t (*get_tick)(void),
+    void (*flush)(void)
+)
+{
+    if (pacer == NULL)
+        return;
+    
+    memset(pacer, 0, sizeof(I2C_OLED_FramePacer));
+    
+    if (get_tick == NULL)
+        get_tick = HAL_GetTick;
+    
+    pacer->get_tick = get_tick;
+    pacer->flush = flush;
+    pacer->step_budget = I2C_OLED_FRAMEPACER_STEP_BUDGET;
+    
+    I2C_OLED_FramePacer_SetTargetFPS(pacer, target_fps);
+    I2C_OLED_FramePacer_ResetStatistics(pacer);
+    
+    pacer->next_frame_tick = pacer->fps_window_start;
+}
+
+void I2C_OLED_FramePacer_SubmitFrame(I2C_OLED_FramePacer *pacer)
+{
+    if (pacer == NULL)
+        return;
+    
+    if (pacer->frame_pending)
+        pacer->frames_dropped++;
+    
+    pacer->frame_pending = true;
+}
+
+static void I2C_OLED_FramePacer_UpdateFPS(I2C_OLED_FramePacer *pacer, uint32_t now)
+{
+    uint32_t elapsed = now - pacer->fps_window_start;
+    
+    if (elapsed < I2C_OLED_FRAMEPACER_FPS_WINDOW)
+        return;
+    
+    pacer->achieved_fps = (uint16_t)(((uint32_t)pacer->fps_window_frames * 1000 + (elapsed / 2)) / elapsed);
+    
+    pacer->fps_window_start = now;
+    pacer->fps_window_frames = 0;
+}
+
+// Frame fully sent at end: statistics, and the grid moves on //
+
+static void I2C_OLED_FramePacer_Presented(I2C_OLED_FramePacer *pacer, uint32_t end)
+{
+    pacer->frame_in_flight = false;
+    
+    pacer->last_flush_duration = end - pacer->flush_start_tick;
+    pacer->frames_presented++;
+    pacer->fps_window_frames++;
+    
+    // Next slot on the grid //
+    
+    pacer->next_frame_tick += pacer->frame_interval;
+    pacer->remainder_accumulator += pacer->interval_remainder;
+    if (pacer->remainder_accumulator >= pacer->target_fps)
+    {
+        pacer->remainder_accumulator -= pacer->target_fps;
+        pacer->next_frame_tick++;
+    }
+    
+    // Overran (slow bus or late submit): drop missed slots, restart the grid at the end of this flush //
+    
+    if ((int32_t)(end - pacer->next_frame_tick) > 0)
+    {
+        pacer->next_frame_tick = end;
+        pacer->remainder_accumulator = 0;
+    }
+}
+
+bool I2C_OLED_FramePacer_Poll(I2C_OLED_FramePacer *pacer)
+{
+    if (pacer == NULL)
+        return false;
+    
+    uint32_t now = pacer->get_tick();
+    
+    I2C_OLED_FramePacer_UpdateFPS(pacer, now);
+    
+    if (!pacer->frame_in_flight)
+    {
+        if (!pacer->frame_pending)
+            return false;
+        
+        if ((int32_t)(now - pacer->next_frame_tick) < 0)
+            return false;
+        
+        // Another driver's transfer still on the bus: keep waiting, newer frames replace this one //
+        
+        if (I2C_OLED_i2c_handler != NULL && HAL_I2C_GetState(I2C_OLED_i2c_handler) != HAL_I2C_STATE_READY)
+            return false;
+        
+        pacer->frame_pending = false;
+        pacer->frame_in_flight = true;
+        pacer->flush_start_tick = now;
+        
+        if (pacer->flush != NULL)
+        {
+            pacer->flush();
+            
+            I2C_OLED_FramePacer_Presented(pacer, pacer->get_tick());
+            return true;
+        }
+        
+        I2C_OLED_FlushBegin();
+    }
+    
+    // Smaller budgets would never send anything //
+    
+    uint16_t budget = pacer->step_budget;
+    
+    if (budget < I2C_OLED_FLUSH_STEP_MIN_BUDGET)
+        budget = I2C_OLED_FLUSH_STEP_MIN_BUDGET;
+    
+    if (!I2C_OLED_FlushStep(budget))
+        return false;
+    
+    I2C_OLED_FramePacer_Presented(pacer, pacer->get_tick());
+    
+    return true;
+}
@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef __I2C_OLED_FRAMEPACER_H__
+#define __I2C_OLED_FRAMEPACER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Window used to compute the achieved frame rate, in ticks (ms) //
+#define I2C_OLED_FRAMEPACER_FPS_WINDOW  1000
+
+// Bytes per poll of the time-sliced flush, about 1 ms at 400 kHz //
+#define I2C_OLED_FRAMEPACER_STEP_BUDGET 40
+
+typedef struct
+{
+    uint32_t (*get_tick)(void);     // Millisecond tick source (HAL_GetTick if NULL)
+    void (*flush)(void);            // Blocking flush function, NULL for I2C_OLED_FlushStep() from Poll
+    uint16_t step_budget;           // Bytes per poll without a flush function
+    
+    uint16_t target_fps;
+    uint32_t frame_interval;        // Integer part of 1000 / target_fps
+    uint16_t interval_remainder;    // Fractional part, accumulated per frame
+    uint16_t remainder_accumulator;
+    
+    uint32_t next_frame_tick;
+    bool frame_pending;
+    
+    bool frame_in_flight;
+    uint32_t flush_start_tick;
+    
+    uint32_t fps_window_start;
+    uint16_t fps_window_frames;
+    
+    // Statistics //
+    
+    uint16_t achieved_fps;
+    uint32_t frames_presented;
+    uint32_t frames_dropped;
+    uint32_t last_flush_duration;
+} I2C_OLED_FramePacer;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    
+    extern void I2C_OLED_FramePacer_Initialize
+    (
+        I2C_OLED_FramePacer *pacer,
+        uint16_t target_fps,
+        uint32_t (*get_tick)(void),
+        void (*flush)(void)
+    );
+    
+    extern void I2C_OLED_FramePacer_SetTargetFPS(I2C_OLED_FramePacer *pacer, uint16_t target_fps);
+    
+    // Call after a new frame has been drawn into the buffer. //
+    extern void I2C_OLED_FramePacer_SubmitFrame(I2C_OLED_FramePacer *pacer);
+    
+    /*
+        Call from the main loop. Returns true when a frame has been fully
+        sent. Without a flush function a frame is sent over several polls,
+        step_budget bytes each, and a frame submitted meanwhile waits for
+        the next slot.
+    */
+    extern bool I2C_OLED_FramePacer_Poll(I2C_OLED_FramePacer *pacer);
+    
+    extern void I2C_OLED_FramePacer_ResetStatistics(I2C_OLED_FramePacer *pacer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
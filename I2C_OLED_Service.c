@@ -0,0 +1,275 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "I2C_OLED_Service.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "I2C_OLED.h"
+#include "I2C_OLED_Atomic.h"
+
+/*
+    Bounded MPSC ring (D. Vyukov's sequence-per-cell queue).
+    
+    A producer claims a slot by advancing enqueue_position with CAS and
+    publishes it by storing position + 1 into the cell's sequence. The
+    consumer takes a cell once its sequence is position + 1 and hands it
+    back with position + QUEUE_SIZE. Producers never wait for each other,
+    so an ISR can submit while a task is halfway through a submit; the
+    consumer just stops at the unpublished cell until the next drain.
+*/
+
+#define I2C_OLED_SERVICE_QUEUE_MASK (I2C_OLED_SERVICE_QUEUE_SIZE - 1)
+
+typedef struct
+{
+    volatile uint32_t sequence;
+    I2C_OLED_Command command;
+} I2C_OLED_ServiceCell;
+
+static I2C_OLED_ServiceCell service_queue[I2C_OLED_SERVICE_QUEUE_SIZE];
+
+static volatile uint32_t enqueue_position = 0;
+static uint32_t dequeue_position = 0;           // Display task only
+
+static volatile uint32_t commands_dropped = 0;
+
+void I2C_OLED_Service_Initialize(void)
+{
+    for (uint32_t i = 0; i < I2C_OLED_SERVICE_QUEUE_SIZE; i++)
+        I2C_OLED_Atomic_Store(&service_queue[i].sequence, i);
+    
+    dequeue_position = 0;
+    I2C_OLED_Atomic_Store(&enqueue_position, 0);
+    I2C_OLED_Atomic_Store(&commands_dropped, 0);
+}
+
+bool I2C_OLED_Service_Submit(const I2C_OLED_Command *command)
+{
+    if (command == NULL)
+        return false;
+    
+    I2C_OLED_ServiceCell *cell;
+    uint32_t position = I2C_OLED_Atomic_Load(&enqueue_position);
+    
+    for (;;)
+    {
+        cell = &service_queue[position & I2C_OLED_SERVICE_QUEUE_MASK];
+        
+        int32_t difference = (int32_t)(I2C_OLED_Atomic_Load(&cell->sequence) - position);
+        
+        if (difference == 0)
+        {
+            if (I2C_OLED_Atomic_CompareExchange(&enqueue_position, &position, position + 1))
+                break;
+        }
+        else if (difference < 0)
+        {
+            // Full //
+            
+            I2C_OLED_Atomic_FetchAdd(&commands_dropped, 1);
+            return false;
+        }
+        else
+        {
+            position = I2C_OLED_Atomic_Load(&enqueue_position);
+        }
+    }
+    
+    cell->command = *command;
+    
+    I2C_OLED_Atomic_Store(&cell->sequence, position + 1);
+    
+    return true;
+}
+
+static bool I2C_OLED_Service_Take(I2C_OLED_Command *command)
+{
+    I2C_OLED_ServiceCell *cell = &service_queue[dequeue_position & I2C_OLED_SERVICE_QUEUE_MASK];
+    
+    if (I2C_OLED_Atomic_Load(&cell->sequence) != dequeue_position + 1)
+        return false;
+    
+    *command = cell->command;
+    
+    I2C_OLED_Atomic_Store(&cell->sequence, dequeue_position + I2C_OLED_SERVICE_QUEUE_SIZE);
+    dequeue_position++;
+    
+    return true;
+}
+
+void I2C_OLED_Service_ClipCommand
+(
+    I2C_OLED_Command *command,
+    int16_t start_x, int16_t start_y,
+    int16_t end_x, int16_t end_y
+)
+{
+    if (command == NULL)
+        return;
+    
+    command->clipped = true;
+    command->clip_start_x = start_x;
+    command->clip_start_y = start_y;
+    command->clip_end_x = end_x;
+    command->clip_end_y = end_y;
+}
+
+static bool I2C_OLED_Service_SubmitBox
+(
+    I2C_OLED_CommandType type,
+    int16_t start_x, int16_t start_y,
+    int16_t end_x, int16_t end_y,
+    bool inverted
+)
+{
+    I2C_OLED_Command command;
+    
+    command.type = type;
+    command.inverted = inverted;
+    command.start_x = start_x;
+    command.start_y = start_y;
+    command.end_x = end_x;
+    command.end_y = end_y;
+    command.clipped = false;
+    
+    return I2C_OLED_Service_Submit(&command);
+}
+
+bool I2C_OLED_Service_Clear(void)
+{
+    return I2C_OLED_Service_SubmitBox(I2C_OLED_COMMAND_CLEAR, 0, 0, 0, 0, false);
+}
+
+bool I2C_OLED_Service_FillRect
+(
+    int16_t start_x, int16_t start_y,
+    int16_t end_x, int16_t end_y,
+    bool inverted
+)
+{
+    return I2C_OLED_Service_SubmitBox(I2C_OLED_COMMAND_FILL_RECT, start_x, start_y, end_x, end_y, inverted);
+}
+
+bool I2C_OLED_Service_DrawRect
+(
+    int16_t start_x, int16_t start_y,
+    int16_t end_x, int16_t end_y,
+    bool inverted
+)
+{
+    return I2C_OLED_Service_SubmitBox(I2C_OLED_COMMAND_DRAW_RECT, start_x, start_y, end_x, end_y, inverted);
+}
+
+bool I2C_OLED_Service_PrintStrXY
+(
+    const char *str,
+    int16_t x, int16_t y,
+    bool inverted
+)
+{
+    if (str == NULL)
+        return false;
+    
+    I2C_OLED_Command command;
+    
+    command.type = I2C_OLED_COMMAND_PRINT_STR_XY;
+    command.inverted = inverted;
+    command.start_x = x;
+    command.start_y = y;
+    command.clipped = false;
+    
+    strncpy(command.text, str, I2C_OLED_SERVICE_TEXT_LENGTH);
+    command.text[I2C_OLED_SERVICE_TEXT_LENGTH] = '\0';
+    
+    return I2C_OLED_Service_Submit(&command);
+}
+
+bool I2C_OLED_Service_Callback(void (*function)(void *argument), void *argument)
+{
+    if (function == NULL)
+        return false;
+    
+    I2C_OLED_Command command;
+    
+    command.type = I2C_OLED_COMMAND_CALLBACK;
+    command.callback.function = function;
+    command.callback.argument = argument;
+    command.clipped = false;
+    
+    return I2C_OLED_Service_Submit(&command);
+}
+
+static void I2C_OLED_Service_Execute(const I2C_OLED_Command *command)
+{
+    switch (command->type)
+    {
+        case I2C_OLED_COMMAND_CLEAR:
+            I2C_OLED_ClearBuffer();
+            break;
+        
+        case I2C_OLED_COMMAND_FILL_RECT:
+            I2C_OLED_FillRect(command->start_x, command->start_y, command->end_x, command->end_y, command->inverted);
+            break;
+        
+        case I2C_OLED_COMMAND_DRAW_RECT:
+            I2C_OLED_DrawRect(command->start_x, command->start_y, command->end_x, command->end_y, command->inverted);
+            break;
+        
+        case I2C_OLED_COMMAND_PRINT_STR_XY:
+            I2C_OLED_PrintStrXY(command->text, command->start_x, command->start_y, command->inverted);
+            break;
+        
+        case I2C_OLED_COMMAND_CALLBACK:
+            command->callback.function(command->callback.argument);
+            break;
+        
+        default:
+            break;
+    }
+}
+
+uint16_t I2C_OLED_Service_Drain(void)
+{
+    I2C_OLED_Command command;
+    uint16_t rendered = 0;
+    
+    // Render into the buffer only, the bus is used once at the end //
+    
+    bool manual_update = I2C_OLED_manual_update;
+    I2C_OLED_manual_update = true;
+    
+    // Bounded, producers that keep submitting can't hold the display task here //
+    
+    while (rendered < I2C_OLED_SERVICE_QUEUE_SIZE && I2C_OLED_Service_Take(&command))
+    {
+        rendered++;
+        
+        if (!command.clipped)
+        {
+            I2C_OLED_Service_Execute(&command);
+            continue;
+        }
+        
+        // A full clip stack drops the command rather than drawing it unclipped //
+        
+        if (I2C_OLED_PushClip(command.clip_start_x, command.clip_start_y, command.clip_end_x, command.clip_end_y))
+        {
+            I2C_OLED_Service_Execute(&command);
+            I2C_OLED_PopClip();
+        }
+    }
+    
+    I2C_OLED_manual_update = manual_update;
+    
+    if (rendered > 0)
+        I2C_OLED_UpdateDirty();
+    
+    return rendered;
+}
+
+uint32_t I2C_OLED_Service_GetDropped(void)
+{
+    return I2C_OLED_Atomic_Load(&commands_dropped);
+}
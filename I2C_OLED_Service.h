@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef __I2C_OLED_SERVICE_H__
+#define __I2C_OLED_SERVICE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Must be a power of 2 //
+#define I2C_OLED_SERVICE_QUEUE_SIZE     32
+
+// Text is copied into the command, longer strings are cut //
+#define I2C_OLED_SERVICE_TEXT_LENGTH    12
+
+typedef enum
+{
+    I2C_OLED_COMMAND_CLEAR,
+    I2C_OLED_COMMAND_FILL_RECT,
+    I2C_OLED_COMMAND_DRAW_RECT,
+    I2C_OLED_COMMAND_PRINT_STR_XY,
+    I2C_OLED_COMMAND_CALLBACK,  // Runs on the display task, e.g. to draw a bitmap
+} I2C_OLED_CommandType;
+
+typedef struct
+{
+    uint8_t type;
+    bool inverted;
+    
+    int16_t start_x, start_y;
+    int16_t end_x, end_y;
+    
+    // Set by I2C_OLED_Service_ClipCommand(), the clip holds for this command only //
+    bool clipped;
+    int16_t clip_start_x, clip_start_y;
+    int16_t clip_end_x, clip_end_y;
+    
+    union
+    {
+        char text[I2C_OLED_SERVICE_TEXT_LENGTH + 1];
+        
+        struct
+        {
+            void (*function)(void *argument);
+            void *argument;
+        } callback;
+    };
+} I2C_OLED_Command;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    
+    /*
+        Service mode: any task or ISR may submit commands, only the display
+        task calls I2C_OLED_Service_Drain() and no one else calls the
+        drawing functions directly. Submitting never blocks, a full queue
+        returns false and counts the command as dropped.
+        
+        Commands of different producers interleave, so there is no clip
+        stack to share: a command carries its own clip rectangle, pushed
+        before and popped after it, with its XY relative to the clip as
+        with I2C_OLED_PushClip(). Callbacks that push clips must pop them.
+    */
+    
+    extern void I2C_OLED_Service_Initialize(void);
+    
+    extern bool I2C_OLED_Service_Submit(const I2C_OLED_Command *command);
+    
+    // Clips a command built for I2C_OLED_Service_Submit() //
+    extern void I2C_OLED_Service_ClipCommand
+    (
+        I2C_OLED_Command *command,
+        int16_t start_x, int16_t start_y,
+        int16_t end_x, int16_t end_y
+    );
+    
+    extern bool I2C_OLED_Service_Clear(void);
+    extern bool I2C_OLED_Service_FillRect
+    (
+        int16_t start_x, int16_t start_y,
+        int16_t end_x, int16_t end_y,
+        bool inverted
+    );
+    extern bool I2C_OLED_Service_DrawRect
+    (
+        int16_t start_x, int16_t start_y,
+        int16_t end_x, int16_t end_y,
+        bool inverted
+    );
+    extern bool I2C_OLED_Service_PrintStrXY
+    (
+        const char *str,
+        int16_t x, int16_t y,
+        bool inverted
+    );
+    extern bool I2C_OLED_Service_Callback(void (*function)(void *argument), void *argument);
+    
+    // Display task: renders everything queued, then sends the dirty area once. Returns commands rendered. //
+    extern uint16_t I2C_OLED_Service_Drain(void);
+    
+    extern uint32_t I2C_OLED_Service_GetDropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
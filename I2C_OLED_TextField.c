@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "I2C_OLED_TextField.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "I2C_OLED.h"
+
+void I2C_OLED_TextField_Initialize
+(
+    I2C_OLED_TextField *field,
+    int16_t x, int16_t y,
+    uint8_t width,
+    bool align_right,
+    bool inverted
+)
+{
+    if (field == NULL)
+        return;
+    
+    if (width > I2C_OLED_TEXTFIELD_LENGTH)
+        width = I2C_OLED_TEXTFIELD_LENGTH;
+    
+    field->x = x;
+    field->y = y;
+    field->width = width;
+    field->align_right = align_right;
+    field->inverted = inverted;
+    
+    I2C_OLED_TextField_Invalidate(field);
+}
+
+void I2C_OLED_TextField_Invalidate(I2C_OLED_TextField *field)
+{
+    if (field == NULL)
+        return;
+    
+    field->valid = false;
+}
+
+uint8_t I2C_OLED_TextField_Set(I2C_OLED_TextField *field, const char *str)
+{
+    if (field == NULL)
+        return 0;
+    
+    if (str == NULL)
+        str = "";
+    
+    // Lay out the new contents, cut to the width //
+    
+    char text[I2C_OLED_TEXTFIELD_LENGTH];
+    
+    int length = 0;
+    while (length < field->width && str[length])
+        length++;
+    
+    int padding = field->align_right ? field->width - length : 0;
+    
+    memset(text, ' ', field->width);
+    memcpy(text + padding, str, length);
+    
+    // Only changed cells //
+    
+    uint8_t cells_drawn = 0;
+    
+    for (int i = 0; i < field->width; i++)
+    {
+        if (field->valid && field->text[i] == text[i])
+            continue;
+        
+        I2C_OLED_PutCharOpaqueXY(text[i], field->x + (i * 6), field->y, field->inverted);
+        
+        field->text[i] = text[i];
+        cells_drawn++;
+    }
+    
+    field->valid = true;
+    
+    return cells_drawn;
+}
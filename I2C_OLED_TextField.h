@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef __I2C_OLED_TEXTFIELD_H__
+#define __I2C_OLED_TEXTFIELD_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Maximum width in characters //
+#define I2C_OLED_TEXTFIELD_LENGTH   16
+
+typedef struct
+{
+    int16_t x, y;           // Relative to the clip origin at the time of drawing
+    uint8_t width;          // Characters, 6 columns each
+    bool align_right;       // Pad on the left, for numbers
+    bool inverted;
+    
+    bool valid;             // False until drawn, then text is what the buffer shows
+    char text[I2C_OLED_TEXTFIELD_LENGTH];
+} I2C_OLED_TextField;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    
+    extern void I2C_OLED_TextField_Initialize
+    (
+        I2C_OLED_TextField *field,
+        int16_t x, int16_t y,
+        uint8_t width,
+        bool align_right,
+        bool inverted
+    );
+    
+    /*
+        Pads or cuts str to the field width and redraws only the cells whose
+        character changed, each as one opaque 6x8 cell with its own dirty box.
+        Returns the number of cells redrawn.
+        
+        Only with manual update off does each box go out on its own, 6 data
+        bytes per cell (12 off the page grid). With manual update on the
+        boxes merge into the dirty area, and everything between two changed
+        cells is sent too: the first and last digit of a 5-digit field cost
+        30 bytes, not 12.
+    */
+    extern uint8_t I2C_OLED_TextField_Set(I2C_OLED_TextField *field, const char *str);
+    
+    // Next Set() redraws every cell, e.g. after the buffer was cleared //
+    extern void I2C_OLED_TextField_Invalidate(I2C_OLED_TextField *field);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "I2C_OLED_Trace.h"
+
+#ifdef I2C_OLED_TRACE
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "I2C_OLED.h"
+
+#include I2C_OLED_HAL_HEADER
+
+/*
+    Recording happens on the caller's context (main loop or display task),
+    the same one that talks to the HAL, so the ring needs no locking.
+*/
+
+static I2C_OLED_TraceEntry trace_ring[I2C_OLED_TRACE_ENTRIES];
+
+static uint16_t trace_head = 0;     // Next entry to write
+static uint16_t trace_count = 0;
+static uint32_t trace_overwritten = 0;
+
+void I2C_OLED_Trace_Record(uint8_t control, const uint8_t *data, uint16_t length)
+{
+    I2C_OLED_TraceEntry *entry = &trace_ring[trace_head];
+    
+    entry->timestamp = I2C_OLED_TRACE_TIMESTAMP();
+    entry->control = control;
+    entry->length = length;
+    
+    uint16_t payload_length = length;
+    if (payload_length > I2C_OLED_TRACE_PAYLOAD)
+        payload_length = I2C_OLED_TRACE_PAYLOAD;
+    
+    if (data != NULL)
+        memcpy(entry->payload, data, payload_length);
+    
+    trace_head = (trace_head + 1) % I2C_OLED_TRACE_ENTRIES;
+    
+    if (trace_count < I2C_OLED_TRACE_ENTRIES)
+        trace_count++;
+    else
+        trace_overwritten++;
+}
+
+void I2C_OLED_Trace_Clear(void)
+{
+    trace_head = 0;
+    trace_count = 0;
+    trace_overwritten = 0;
+}
+
+uint16_t I2C_OLED_Trace_Read(I2C_OLED_TraceEntry *out_entries, uint16_t max_entries)
+{
+    if (out_entries == NULL)
+        return 0;
+    
+    uint16_t count = trace_count;
+    if (count > max_entries)
+        count = max_entries;
+    
+    uint16_t index = (trace_head + I2C_OLED_TRACE_ENTRIES - trace_count) % I2C_OLED_TRACE_ENTRIES;
+    
+    for (int i = 0; i < count; i++)
+    {
+        out_entries[i] = trace_ring[index];
+        index = (index + 1) % I2C_OLED_TRACE_ENTRIES;
+    }
+    
+    return count;
+}
+
+uint32_t I2C_OLED_Trace_GetOverwritten(void)
+{
+    return trace_overwritten;
+}
+
+static char *I2C_OLED_Trace_PutHex(char *ptr_line, uint32_t value, int digits)
+{
+    static const char hex_digits[] = "0123456789ABCDEF";
+    
+    for (int i = digits - 1; i >= 0; i--)
+        *ptr_line++ = hex_digits[(value >> (i * 4)) & 0x0F];
+    
+    return ptr_line;
+}
+
+void I2C_OLED_Trace_Dump(void (*write_line)(const char *line))
+{
+    // Timestamp, control, length, payload bytes, separators, line end //
+    
+    char line[8 + 1 + 2 + 1 + 4 + (I2C_OLED_TRACE_PAYLOAD * 3) + 3];
+    
+    if (write_line == NULL)
+        return;
+    
+    uint16_t index = (trace_head + I2C_OLED_TRACE_ENTRIES - trace_count) % I2C_OLED_TRACE_ENTRIES;
+    
+    for (int i = 0; i < trace_count; i++)
+    {
+        const I2C_OLED_TraceEntry *entry = &trace_ring[index];
+        
+        char *ptr_line = line;
+        
+        ptr_line = I2C_OLED_Trace_PutHex(ptr_line, entry->timestamp, 8);
+        *ptr_line++ = ' ';
+        ptr_line = I2C_OLED_Trace_PutHex(ptr_line, entry->control, 2);
+        *ptr_line++ = ' ';
+        ptr_line = I2C_OLED_Trace_PutHex(ptr_line, entry->length, 4);
+        
+        uint16_t payload_length = entry->length;
+        if (payload_length > I2C_OLED_TRACE_PAYLOAD)
+            payload_length = I2C_OLED_TRACE_PAYLOAD;
+        
+        for (int j = 0; j < payload_length; j++)
+        {
+            *ptr_line++ = ' ';
+            ptr_line = I2C_OLED_Trace_PutHex(ptr_line, entry->payload[j], 2);
+        }
+        
+        *ptr_line++ = '\r';
+        *ptr_line++ = '\n';
+        *ptr_line = '\0';
+        
+        write_line(line);
+        
+        index = (index + 1) % I2C_OLED_TRACE_ENTRIES;
+    }
+}
+
+#endif
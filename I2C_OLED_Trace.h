@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef __I2C_OLED_TRACE_H__
+#define __I2C_OLED_TRACE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+    Transfer trace, built only with I2C_OLED_TRACE defined. Every write the
+    driver issues is recorded into a ring buffer before it goes to the HAL,
+    the oldest entries are overwritten.
+    
+    Mem_Write transfers record their memory address (0x00 commands, 0x40
+    data) as the control byte. Packets (I2C_OLED_Packet_Send()) record
+    their first control byte, always 0x80, and the payload is the rest of
+    the packet: the Co-bit control bytes stay in it, between the commands
+    and data they announce. host/trace_analyze.c decodes dumps of both.
+*/
+
+#ifndef I2C_OLED_TRACE_ENTRIES
+#define I2C_OLED_TRACE_ENTRIES      32
+#endif
+
+// Payload bytes kept per entry, the length is always recorded in full //
+#ifndef I2C_OLED_TRACE_PAYLOAD
+#define I2C_OLED_TRACE_PAYLOAD      16
+#endif
+
+// Timestamp source, HAL_GetTick() (ms) unless overridden, e.g. with the DWT cycle counter //
+#ifndef I2C_OLED_TRACE_TIMESTAMP
+#define I2C_OLED_TRACE_TIMESTAMP()  HAL_GetTick()
+#endif
+
+typedef struct
+{
+    uint32_t timestamp;
+    uint8_t control;        // Control byte, for packets the first one (0x80, the payload keeps the other control bytes)
+    uint16_t length;        // Bytes after the control byte
+    uint8_t payload[I2C_OLED_TRACE_PAYLOAD];
+} I2C_OLED_TraceEntry;
+
+#ifdef I2C_OLED_TRACE
+#define I2C_OLED_TRACE_WRITE(control, data, length)     I2C_OLED_Trace_Record((control), (data), (length))
+#else
+#define I2C_OLED_TRACE_WRITE(control, data, length)     ((void)0)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    
+    extern void I2C_OLED_Trace_Record(uint8_t control, const uint8_t *data, uint16_t length);
+    
+    extern void I2C_OLED_Trace_Clear(void);
+    
+    // Copies up to max_entries, oldest first, without removing them. Returns the number copied. //
+    extern uint16_t I2C_OLED_Trace_Read(I2C_OLED_TraceEntry *out_entries, uint16_t max_entries);
+    
+    // Entries lost to overwriting since the last clear //
+    extern uint32_t I2C_OLED_Trace_GetOverwritten(void);
+    
+    /*
+        One text line per entry, oldest first, e.g. for a UART:
+        "<timestamp> <control> <length> <payload bytes>", all hex.
+    */
+    extern void I2C_OLED_Trace_Dump(void (*write_line)(const char *line));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
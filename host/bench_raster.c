@@ -0,0 +1,604 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/*
+    Raster benchmark: I2C_OLED.c built against the null HAL with manual
+    update on, so only the work on I2C_OLED_buffer is measured.
+    
+    Every primitive runs in each combination of aligned/unaligned y,
+    unclipped/clipped, small/full-screen and normal/inverted. The grayscale
+    blit draws a 64x64 (small) or 128x64 (full) 8-bit image with each
+    dither mode. Reported per
+    workload:
+        ns/op           best of several runs, thread CPU time
+        instr/op        instructions retired (perf counter, 0 if unavailable)
+        bytes           buffer bytes under the area one op marks dirty
+    
+    Regressions are judged on instr/op, which does not move with host load,
+    and on ns/op only when the counter is unavailable. A changed bytes
+    count always fails, it means the primitive draws a different area.
+    
+    bench_raster                    print results
+    bench_raster -c <baseline>      compare, exit status 1 on a regression
+    bench_raster -w <baseline>      write the results as a new baseline
+    bench_raster -f <text>          only workloads whose name contains text
+    bench_raster -t <percent>       increase allowed for workloads written with -w (default 10)
+    
+    The 64x64 grayscale frames are also held against 30 fps on a 72 MHz
+    Cortex-M3 (2.4 M cycles per frame), estimated from host instructions
+    at BENCH_M3_CYCLES_PER_INSTRUCTION. Exceeding it fails like a regression.
+*/
+
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "I2C_OLED.h"
+
+#define BENCH_MAX_WORKLOADS     160
+#define BENCH_NAME_LENGTH       64
+
+// Iterations are calibrated so one timed run takes at least this long, the best run is kept //
+#define BENCH_RUN_NS            2000000.0
+#define BENCH_RUNS              15
+
+// Extra measurements of a workload that looks like a regression //
+#define BENCH_RETRIES           2
+
+/*
+    Cortex-M3 estimate: Thumb-2 needs more instructions than x86-64 for the
+    same loop (no memory operands, 32-bit registers) and runs from flash with
+    wait states, 2 cycles per host instruction is on the safe side.
+*/
+#define BENCH_M3_CLOCK_HZ                   72000000.0
+#define BENCH_M3_CYCLES_PER_INSTRUCTION     2.0
+#define BENCH_GRAYSCALE_FPS                 30.0
+
+typedef enum
+{
+    BENCH_FILL_RECT,
+    BENCH_DRAW_RECT,
+    BENCH_PUT_CHAR_XY,
+    BENCH_PRINT_STR_XY,
+    BENCH_GRAYSCALE_THRESHOLD,
+    BENCH_GRAYSCALE_BAYER,
+    BENCH_GRAYSCALE_FLOYD_STEINBERG,
+    BENCH_PRIMITIVES,
+} BenchPrimitive;
+
+typedef struct
+{
+    char name[BENCH_NAME_LENGTH];
+    
+    uint8_t primitive;
+    bool unaligned;
+    bool clipped;
+    bool full;
+    bool inverted;
+    
+    double ns_per_op;
+    double instructions_per_op;
+    uint32_t bytes_touched;
+} BenchWorkload;
+
+typedef struct
+{
+    char name[BENCH_NAME_LENGTH];
+    double ns_per_op;
+    double instructions_per_op;
+    uint32_t bytes_touched;
+    double max_increase_percent;
+} BenchBaseline;
+
+static const char *const primitive_names[] =
+{
+    "fill_rect",
+    "draw_rect",
+    "put_char_xy",
+    "print_str_xy",
+    "gray_threshold",
+    "gray_bayer",
+    "gray_floyd_steinberg",
+};
+
+static BenchWorkload workloads[BENCH_MAX_WORKLOADS];
+static int workload_count = 0;
+
+static BenchBaseline baselines[BENCH_MAX_WORKLOADS];
+static int baseline_count = 0;
+
+// Instruction counter, -1 when perf events are not available //
+static int instruction_counter = -1;
+
+// 21 x 8 characters, the whole screen //
+static char full_screen_text[(22 * 8) + 1];
+
+// Grayscale source, 128x64: diagonal gradient with some noise //
+static uint8_t grayscale_image[I2C_OLED_COLUMNS * I2C_OLED_ROWS];
+
+// Measurement //
+
+static double Bench_Now(void)
+{
+    struct timespec now;
+    
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    
+    return (now.tv_sec * 1e9) + now.tv_nsec;
+}
+
+static void Bench_OpenInstructionCounter(void)
+{
+    struct perf_event_attr attributes;
+    
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.size = sizeof(attributes);
+    attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    
+    instruction_counter = syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+}
+
+static uint64_t Bench_ReadInstructions(void)
+{
+    uint64_t count = 0;
+    
+    if (instruction_counter < 0 || read(instruction_counter, &count, sizeof(count)) != sizeof(count))
+        return 0;
+    
+    return count;
+}
+
+// Workloads //
+
+/*
+    Clipped workloads draw inside the clip rectangle (8, 8)-(119, 55), whose
+    origin is page aligned. Small shapes straddle its left edge (and its top
+    edge when unaligned), full-screen ones overhang it on every side.
+*/
+
+static void Bench_Position(const BenchWorkload *workload, int16_t *out_x, int16_t *out_y)
+{
+    if (workload->full)
+    {
+        *out_x = 0;
+        *out_y = workload->unaligned ? 3 : 0;
+    }
+    else if (workload->clipped)
+    {
+        *out_x = -4;
+        *out_y = workload->unaligned ? -5 : 0;
+    }
+    else
+    {
+        *out_x = 20;
+        *out_y = workload->unaligned ? 19 : 16;
+    }
+}
+
+static void Bench_Run(const BenchWorkload *workload)
+{
+    int16_t x, y;
+    
+    Bench_Position(workload, &x, &y);
+    
+    int16_t end_x = workload->full ? x + I2C_OLED_COLUMNS - 1 : x + 15;
+    int16_t end_y = workload->full ? y + I2C_OLED_ROWS - 1 : y + 11;
+    
+    switch (workload->primitive)
+    {
+        case BENCH_FILL_RECT:
+            I2C_OLED_FillRect(x, y, end_x, end_y, workload->inverted);
+            break;
+        
+        case BENCH_DRAW_RECT:
+            I2C_OLED_DrawRect(x, y, end_x, end_y, workload->inverted);
+            break;
+        
+        case BENCH_PUT_CHAR_XY:
+            if (!workload->full)
+            {
+                I2C_OLED_PutCharXY('A', x, y, workload->inverted);
+                break;
+            }
+            
+            for (int row = 0; row < 8; row++)
+            {
+                for (int column = 0; column < 21; column++)
+                    I2C_OLED_PutCharXY('A' + column, x + (column * 6), y + (row * 8), workload->inverted);
+            }
+            break;
+        
+        case BENCH_PRINT_STR_XY:
+            I2C_OLED_PrintStrXY(workload->full ? full_screen_text : "Hello", x, y, workload->inverted);
+            break;
+        
+        case BENCH_GRAYSCALE_THRESHOLD:
+        case BENCH_GRAYSCALE_BAYER:
+        case BENCH_GRAYSCALE_FLOYD_STEINBERG:
+            I2C_OLED_DrawGrayscale
+            (
+                grayscale_image,
+                x, y,
+                workload->full ? I2C_OLED_COLUMNS : 64, workload->full ? I2C_OLED_ROWS : 64,
+                (I2C_OLED_DitherMode)(I2C_OLED_DITHER_THRESHOLD + (workload->primitive - BENCH_GRAYSCALE_THRESHOLD)),
+                workload->inverted
+            );
+            break;
+        
+        default:
+            break;
+    }
+}
+
+static void Bench_AddWorkloads(void)
+{
+    for (int primitive = 0; primitive < BENCH_PRIMITIVES; primitive++)
+    {
+        for (int variant = 0; variant < 16; variant++)
+        {
+            BenchWorkload *workload = &workloads[workload_count++];
+            
+            workload->primitive = primitive;
+            workload->unaligned = variant & 0x08;
+            workload->clipped = variant & 0x04;
+            workload->full = variant & 0x02;
+            workload->inverted = variant & 0x01;
+            
+            snprintf
+            (
+                workload->name, sizeof(workload->name), "%s/%s/%s/%s/%s",
+                primitive_names[primitive],
+                workload->unaligned ? "unaligned" : "aligned",
+                workload->clipped ? "clipped" : "unclipped",
+                workload->full ? "full" : "small",
+                workload->inverted ? "inverted" : "normal"
+            );
+        }
+    }
+}
+
+static void Bench_Measure(BenchWorkload *workload)
+{
+    I2C_OLED_ResetClip();
+    I2C_OLED_ClearBuffer();
+    
+    if (workload->clipped)
+        I2C_OLED_PushClip(8, 8, I2C_OLED_COLUMNS - 9, I2C_OLED_ROWS - 9);
+    
+    // Bytes touched: buffer bytes under the area one op marks dirty //
+    
+    I2C_OLED_dirty.start_x = 0;
+    I2C_OLED_dirty.start_y = 0;
+    I2C_OLED_dirty.end_x = -1;
+    I2C_OLED_dirty.end_y = -1;
+    
+    Bench_Run(workload);
+    
+    workload->bytes_touched = 0;
+    
+    if (I2C_OLED_dirty.start_x <= I2C_OLED_dirty.end_x)
+        workload->bytes_touched = (I2C_OLED_dirty.end_x - I2C_OLED_dirty.start_x + 1) * ((I2C_OLED_dirty.end_y / 8) - (I2C_OLED_dirty.start_y / 8) + 1);
+    
+    // Calibrate the iteration count, then keep the best run //
+    
+    long iterations = 1;
+    
+    for (;;)
+    {
+        double start = Bench_Now();
+        
+        for (long i = 0; i < iterations; i++)
+            Bench_Run(workload);
+        
+        if (Bench_Now() - start >= BENCH_RUN_NS / 4)
+            break;
+        
+        iterations *= 2;
+    }
+    
+    iterations *= 4;
+    
+    double best_ns = INFINITY;
+    double best_instructions = INFINITY;
+    
+    for (int run = 0; run < BENCH_RUNS; run++)
+    {
+        uint64_t instructions = Bench_ReadInstructions();
+        double start = Bench_Now();
+        
+        for (long i = 0; i < iterations; i++)
+            Bench_Run(workload);
+        
+        double ns_per_op = (Bench_Now() - start) / iterations;
+        double instructions_per_op = (double)(Bench_ReadInstructions() - instructions) / iterations;
+        
+        if (ns_per_op < best_ns)
+            best_ns = ns_per_op;
+        if (instructions_per_op < best_instructions)
+            best_instructions = instructions_per_op;
+    }
+    
+    workload->ns_per_op = best_ns;
+    workload->instructions_per_op = best_instructions;
+    
+    I2C_OLED_ResetClip();
+}
+
+// Baseline file: "<name> <ns/op> <instr/op> <bytes> <max increase %>" per line, # comments //
+
+static bool Bench_ReadBaseline(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    
+    if (file == NULL)
+    {
+        fprintf(stderr, "bench_raster: cannot read %s\n", path);
+        return false;
+    }
+    
+    char line[256];
+    
+    while (fgets(line, sizeof(line), file) != NULL && baseline_count < BENCH_MAX_WORKLOADS)
+    {
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r')
+            continue;
+        
+        BenchBaseline *baseline = &baselines[baseline_count];
+        
+        if (sscanf(line, "%63s %lf %lf %u %lf", baseline->name, &baseline->ns_per_op, &baseline->instructions_per_op, &baseline->bytes_touched, &baseline->max_increase_percent) == 5)
+            baseline_count++;
+    }
+    
+    fclose(file);
+    
+    return true;
+}
+
+static bool Bench_WriteBaseline(const char *path, double max_increase_percent)
+{
+    FILE *file = fopen(path, "w");
+    
+    if (file == NULL)
+    {
+        fprintf(stderr, "bench_raster: cannot write %s\n", path);
+        return false;
+    }
+    
+    fprintf(file, "# bench_raster baseline, regenerate with: make bench-baseline\n");
+    fprintf(file, "# name ns/op instr/op bytes max_increase_%%\n");
+    
+    for (int i = 0; i < workload_count; i++)
+    {
+        const BenchWorkload *workload = &workloads[i];
+        
+        fprintf(file, "%s %.1f %.1f %u %.0f\n", workload->name, workload->ns_per_op, workload->instructions_per_op, workload->bytes_touched, max_increase_percent);
+    }
+    
+    fclose(file);
+    
+    return true;
+}
+
+static const BenchBaseline *Bench_FindBaseline(const char *name)
+{
+    for (int i = 0; i < baseline_count; i++)
+    {
+        if (strcmp(baselines[i].name, name) == 0)
+            return &baselines[i];
+    }
+    
+    return NULL;
+}
+
+// Change of the judged metric in percent //
+
+static double Bench_Change(const BenchWorkload *workload, const BenchBaseline *baseline)
+{
+    if (instruction_counter >= 0 && baseline->instructions_per_op > 0.0)
+        return ((workload->instructions_per_op / baseline->instructions_per_op) - 1.0) * 100.0;
+    
+    return ((workload->ns_per_op / baseline->ns_per_op) - 1.0) * 100.0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *compare_path = NULL;
+    const char *write_path = NULL;
+    const char *filter = NULL;
+    double max_increase_percent = 10.0;
+    
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+            compare_path = argv[++i];
+        else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+            write_path = argv[++i];
+        else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+            filter = argv[++i];
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+            max_increase_percent = atof(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [-c baseline] [-w baseline] [-f filter] [-t percent]\n", argv[0]);
+            return 2;
+        }
+    }
+    
+    if (compare_path != NULL && !Bench_ReadBaseline(compare_path))
+        return 2;
+    
+    char *ptr_text = full_screen_text;
+    
+    for (int row = 0; row < 8; row++)
+    {
+        for (int column = 0; column < 21; column++)
+            *ptr_text++ = 'A' + ((row + column) % 26);
+        
+        if (row < 7)
+            *ptr_text++ = '\n';
+    }
+    
+    *ptr_text = '\0';
+    
+    uint32_t noise = 1;
+    
+    for (int row = 0; row < I2C_OLED_ROWS; row++)
+    {
+        for (int column = 0; column < I2C_OLED_COLUMNS; column++)
+        {
+            noise = (noise * 1103515245) + 12345;
+            
+            grayscale_image[(row * I2C_OLED_COLUMNS) + column] = (uint8_t)(((column + row) * 255 / (I2C_OLED_COLUMNS + I2C_OLED_ROWS - 2)) ^ ((noise >> 16) & 0x0F));
+        }
+    }
+    
+    static I2C_HandleTypeDef i2c_handler;
+    
+    I2C_OLED_Initialize(&i2c_handler);
+    I2C_OLED_manual_update = true;
+    
+    Bench_OpenInstructionCounter();
+    
+    if (instruction_counter < 0)
+        printf("perf instruction counter unavailable, judging ns/op (noisy on a busy host)\n\n");
+    
+    Bench_AddWorkloads();
+    
+    // Filtered out workloads are dropped, so -w never writes them //
+    
+    int kept = 0;
+    
+    for (int i = 0; i < workload_count; i++)
+    {
+        if (filter == NULL || strstr(workloads[i].name, filter) != NULL)
+            workloads[kept++] = workloads[i];
+    }
+    
+    workload_count = kept;
+    
+    int regressions = 0;
+    double log_change_sum = 0.0;
+    int compared = 0;
+    
+    printf("%-56s %9s %9s %6s", "workload", "ns/op", "instr/op", "bytes");
+    if (compare_path != NULL)
+        printf(" %9s %9s %8s  %s", "base ns", "base inst", "change", "status");
+    printf("\n");
+    
+    for (int i = 0; i < workload_count; i++)
+    {
+        BenchWorkload *workload = &workloads[i];
+        const BenchBaseline *baseline = Bench_FindBaseline(workload->name);
+        
+        Bench_Measure(workload);
+        
+        // Measured again before it counts as a regression, a busy host can stall a whole run //
+        
+        for (int retry = 0; retry < BENCH_RETRIES && baseline != NULL; retry++)
+        {
+            if (Bench_Change(workload, baseline) <= baseline->max_increase_percent)
+                break;
+            
+            BenchWorkload again = *workload;
+            
+            Bench_Measure(&again);
+            
+            if (again.ns_per_op < workload->ns_per_op)
+                workload->ns_per_op = again.ns_per_op;
+            if (again.instructions_per_op < workload->instructions_per_op)
+                workload->instructions_per_op = again.instructions_per_op;
+        }
+        
+        printf("%-56s %9.1f %9.1f %6u", workload->name, workload->ns_per_op, workload->instructions_per_op, workload->bytes_touched);
+        
+        if (compare_path != NULL)
+        {
+            if (baseline == NULL)
+            {
+                printf(" %9s %9s %8s  new", "-", "-", "-");
+            }
+            else
+            {
+                double change = Bench_Change(workload, baseline);
+                const char *status = "ok";
+                
+                if (workload->bytes_touched != baseline->bytes_touched)
+                {
+                    status = "REGRESSION (bytes touched changed)";
+                    regressions++;
+                }
+                else if (change > baseline->max_increase_percent)
+                {
+                    status = "REGRESSION";
+                    regressions++;
+                }
+                else if (change < -baseline->max_increase_percent)
+                {
+                    status = "improved";
+                }
+                
+                printf(" %9.1f %9.1f %+7.1f%%  %s", baseline->ns_per_op, baseline->instructions_per_op, change, status);
+                
+                log_change_sum += log1p(change / 100.0);
+                compared++;
+            }
+        }
+        
+        printf("\n");
+        fflush(stdout);
+    }
+    
+    if (compared > 0)
+        printf("\ngeometric mean change: %+.1f%%, %d regression(s)\n", expm1(log_change_sum / compared) * 100.0, regressions);
+    
+    // 64x64 grayscale at 30 fps on a 72 MHz Cortex-M3 //
+    
+    if (instruction_counter >= 0)
+    {
+        double budget_cycles = BENCH_M3_CLOCK_HZ / BENCH_GRAYSCALE_FPS;
+        bool printed = false;
+        
+        for (int i = 0; i < workload_count; i++)
+        {
+            const BenchWorkload *workload = &workloads[i];
+            
+            if (workload->primitive < BENCH_GRAYSCALE_THRESHOLD || workload->full || workload->clipped)
+                continue;
+            
+            if (!printed)
+            {
+                printf("\n64x64 grayscale on a 72 MHz Cortex-M3, estimated at %.1f cycles per host instruction:\n", BENCH_M3_CYCLES_PER_INSTRUCTION);
+                printed = true;
+            }
+            
+            double cycles = workload->instructions_per_op * BENCH_M3_CYCLES_PER_INSTRUCTION;
+            double percent = cycles / budget_cycles * 100.0;
+            
+            printf("%-56s %9.0f cycles, %5.1f%% of a %.0f fps frame", workload->name, cycles, percent, BENCH_GRAYSCALE_FPS);
+            
+            if (percent > 100.0)
+            {
+                printf("  OVER BUDGET");
+                regressions++;
+            }
+            
+            printf("\n");
+        }
+    }
+    
+    if (write_path != NULL && !Bench_WriteBaseline(write_path, max_increase_percent))
+        return 2;
+    
+    return regressions > 0 ? 1 : 0;
+}
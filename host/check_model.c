@@ -0,0 +1,632 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/*
+    Driver checks against the SSD1306 model: whatever the driver sends
+    must leave the panel showing its buffer. Built once per panel height
+    by the Makefile (I2C_OLED_PANEL_ROWS 64 and 32).
+    
+    Exit status 0 when every check passed.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "I2C_OLED.h"
+#include "Font_VertHorz.h"
+#include "null_hal.h"
+#include "ssd1306_model.h"
+
+#define CHECK_ITERATIONS        300
+
+static int failures = 0;
+
+#define CHECK_EXPECT(condition, ...)                                \
+    do                                                              \
+    {                                                               \
+        if (!(condition))                                           \
+        {                                                           \
+            printf("  FAIL %s:%d: ", __FILE__, __LINE__);           \
+            printf(__VA_ARGS__);                                    \
+            printf("\n");                                           \
+            failures++;                                             \
+        }                                                           \
+    } while (0)
+
+static I2C_HandleTypeDef i2c_handler;
+
+// Panel //
+
+static bool Check_LogicalPixel(int16_t x, int16_t y)
+{
+    return (I2C_OLED_buffer[((y >> 3) * I2C_OLED_logical_columns) + x] >> (y & 7)) & 1;
+}
+
+// Panel position of a logical pixel, clockwise rotations //
+
+static void Check_ToPanel(int16_t x, int16_t y, uint8_t *out_x, uint8_t *out_y)
+{
+    switch (I2C_OLED_rotation)
+    {
+        case I2C_OLED_ROTATION_90:
+            *out_x = (I2C_OLED_COLUMNS - 1) - y;
+            *out_y = x;
+            break;
+        case I2C_OLED_ROTATION_180:
+            *out_x = (I2C_OLED_COLUMNS - 1) - x;
+            *out_y = (I2C_OLED_ROWS - 1) - y;
+            break;
+        case I2C_OLED_ROTATION_270:
+            *out_x = y;
+            *out_y = (I2C_OLED_ROWS - 1) - x;
+            break;
+        default:
+            *out_x = x;
+            *out_y = y;
+            break;
+    }
+}
+
+// Pixels the panel shows differently from the buffer //
+
+static int Check_PanelDifferences(void)
+{
+    int differences = 0;
+    
+    for (int16_t y = 0; y < I2C_OLED_logical_rows; y++)
+    {
+        for (int16_t x = 0; x < I2C_OLED_logical_columns; x++)
+        {
+            uint8_t panel_x, panel_y;
+            
+            Check_ToPanel(x, y, &panel_x, &panel_y);
+            
+            if (SSD1306_Model_GetPixel(panel_x, panel_y) != Check_LogicalPixel(x, y))
+                differences++;
+        }
+    }
+    
+    return differences;
+}
+
+static bool Check_PanelChanged(const uint8_t *shown)
+{
+    for (uint8_t y = 0; y < I2C_OLED_ROWS; y++)
+    {
+        for (uint8_t x = 0; x < I2C_OLED_COLUMNS; x++)
+        {
+            if (shown[(y * I2C_OLED_COLUMNS) + x] != SSD1306_Model_GetPixel(x, y))
+                return true;
+        }
+    }
+    
+    return false;
+}
+
+static void Check_RandomizeBuffer(void)
+{
+    for (int i = 0; i < I2C_OLED_BUFFER_SIZE; i++)
+        I2C_OLED_buffer[i] = rand();
+}
+
+static void Check_RandomRegion(uint8_t *start_column, uint8_t *end_column, uint8_t *start_page, uint8_t *end_page)
+{
+    *start_column = rand() % I2C_OLED_logical_columns;
+    *end_column = rand() % I2C_OLED_logical_columns;
+    *start_page = rand() % I2C_OLED_logical_pages;
+    *end_page = rand() % I2C_OLED_logical_pages;
+}
+
+// Startup: the init sequence leaves page addressing, ClearDirect and Resume return to it //
+
+static void Check_Init(void)
+{
+    printf("init: page addressing after Initialize, ClearDirect and Resume\n");
+    
+    // Power-on GDDRAM content is random //
+    
+    SSD1306_Model_Reset();
+    
+    for (int page = 0; page < SSD1306_MODEL_PAGES; page++)
+        for (int column = 0; column < SSD1306_MODEL_COLUMNS; column++)
+            ssd1306_model.ram[page][column] = rand();
+    
+    I2C_OLED_Initialize(&i2c_handler);
+    
+    CHECK_EXPECT(ssd1306_model.mode == SSD1306_MODEL_PAGE, "addressing mode %d after Initialize", ssd1306_model.mode);
+    CHECK_EXPECT(ssd1306_model.multiplex == I2C_OLED_ROWS, "multiplex ratio %d", ssd1306_model.multiplex);
+    CHECK_EXPECT(ssd1306_model.display_on, "display off after Initialize");
+    
+    I2C_OLED_ClearDirect();
+    
+    int set = 0;
+    
+    for (int page = 0; page < SSD1306_MODEL_PAGES; page++)
+        for (int column = 0; column < SSD1306_MODEL_COLUMNS; column++)
+            set += ssd1306_model.ram[page][column] != 0;
+    
+    CHECK_EXPECT(set == 0, "%d GDDRAM bytes left after ClearDirect", set);
+    CHECK_EXPECT(ssd1306_model.mode == SSD1306_MODEL_PAGE, "addressing mode %d after ClearDirect", ssd1306_model.mode);
+    
+    Check_RandomizeBuffer();
+    I2C_OLED_Update();
+    
+    int differences = Check_PanelDifferences();
+    
+    CHECK_EXPECT(differences == 0, "Update after ClearDirect: %d pixels differ", differences);
+    
+    // Sleep with RAM kept, then with power lost: the panel shows the buffer again //
+    
+    I2C_OLED_Sleep();
+    
+    CHECK_EXPECT(!ssd1306_model.display_on, "display on after Sleep");
+    
+    I2C_OLED_Resume(true);
+    
+    differences = Check_PanelDifferences();
+    
+    CHECK_EXPECT(ssd1306_model.display_on && differences == 0, "Resume with RAM kept: %d pixels differ", differences);
+    
+    I2C_OLED_Sleep();
+    SSD1306_Model_Reset();
+    
+    for (int page = 0; page < SSD1306_MODEL_PAGES; page++)
+        for (int column = 0; column < SSD1306_MODEL_COLUMNS; column++)
+            ssd1306_model.ram[page][column] = rand();
+    
+    I2C_OLED_Resume(false);
+    
+    differences = Check_PanelDifferences();
+    
+    CHECK_EXPECT(ssd1306_model.display_on && differences == 0, "Resume after power loss: %d pixels differ", differences);
+    
+    // No page or column nibble command was sent outside page mode //
+    
+    CHECK_EXPECT(ssd1306_model.ignored_commands == 0, "%u addressing commands ignored by the controller", ssd1306_model.ignored_commands);
+}
+
+// Rotation: full, partial and dirty-area updates in every rotation //
+
+static void Check_Rotation(void)
+{
+    printf("rotation: Update, UpdatePartially, UpdateDirty and drawing with auto update\n");
+    
+    for (int rotation = I2C_OLED_ROTATION_0; rotation <= I2C_OLED_ROTATION_270; rotation++)
+    {
+        I2C_OLED_SetRotation(rotation);
+        
+        Check_RandomizeBuffer();
+        I2C_OLED_Update();
+        
+        int differences = Check_PanelDifferences();
+        
+        CHECK_EXPECT(differences == 0, "rotation %d, Update: %d pixels differ", rotation, differences);
+        
+        for (int i = 0; i < CHECK_ITERATIONS && differences == 0; i++)
+        {
+            uint8_t start_column, end_column, start_page, end_page;
+            
+            Check_RandomRegion(&start_column, &end_column, &start_page, &end_page);
+            Check_RandomizeBuffer();
+            
+            // Outside the region the panel keeps what it had, so the buffer gets it back first //
+            
+            I2C_OLED_UpdatePartially(start_column, end_column, start_page, end_page);
+            I2C_OLED_Update();
+            
+            differences = Check_PanelDifferences();
+            
+            CHECK_EXPECT(differences == 0, "rotation %d, UpdatePartially: %d pixels differ", rotation, differences);
+        }
+        
+        I2C_OLED_manual_update = true;
+        
+        for (int i = 0; i < CHECK_ITERATIONS && differences == 0; i++)
+        {
+            I2C_OLED_FillRect(rand() % 150 - 10, rand() % 150 - 10, rand() % 150 - 10, rand() % 150 - 10, rand() & 1);
+            I2C_OLED_PrintStrXY("Hi 12", rand() % 140 - 10, rand() % 140 - 10, rand() & 1);
+            
+            if (rand() % 3 != 0)
+                continue;
+            
+            I2C_OLED_UpdateDirty();
+            
+            differences = Check_PanelDifferences();
+            
+            CHECK_EXPECT(differences == 0, "rotation %d, UpdateDirty: %d pixels differ", rotation, differences);
+        }
+        
+        I2C_OLED_UpdateDirty();
+        I2C_OLED_manual_update = false;
+        
+        for (int i = 0; i < CHECK_ITERATIONS && differences == 0; i++)
+        {
+            I2C_OLED_FillRect(rand() % 150 - 10, rand() % 150 - 10, rand() % 150 - 10, rand() % 150 - 10, rand() & 1);
+            I2C_OLED_DrawRect(rand() % 150 - 10, rand() % 150 - 10, rand() % 150 - 10, rand() % 150 - 10, rand() & 1);
+            I2C_OLED_PrintStrXY("Ab\ncd", rand() % 140 - 10, rand() % 140 - 10, rand() & 1);
+            
+            differences = Check_PanelDifferences();
+            
+            CHECK_EXPECT(differences == 0, "rotation %d, auto update: %d pixels differ", rotation, differences);
+        }
+    }
+    
+    I2C_OLED_SetRotation(I2C_OLED_ROTATION_0);
+}
+
+// Rotation keeps pushed clips, trimmed to the new logical size //
+
+static void Check_RotationClip(void)
+{
+    printf("rotation clip: pushed clips survive SetRotation\n");
+    
+    I2C_OLED_ResetClip();
+    I2C_OLED_PushClip(10, 10, 100, 20);
+    
+    I2C_OLED_SetRotation(I2C_OLED_ROTATION_90);
+    
+    CHECK_EXPECT
+    (
+        I2C_OLED_clip.start_x == 10 && I2C_OLED_clip.end_x == I2C_OLED_logical_columns - 1 &&
+        I2C_OLED_clip.start_y == 10 && I2C_OLED_clip.end_y == 20 &&
+        I2C_OLED_clip.origin_x == 10 && I2C_OLED_clip.origin_y == 10,
+        "clip (%d, %d)-(%d, %d) origin (%d, %d) after rotating to 90",
+        I2C_OLED_clip.start_x, I2C_OLED_clip.start_y, I2C_OLED_clip.end_x, I2C_OLED_clip.end_y,
+        I2C_OLED_clip.origin_x, I2C_OLED_clip.origin_y
+    );
+    
+    // The unclipped level is the whole rotated screen //
+    
+    I2C_OLED_PopClip();
+    
+    CHECK_EXPECT
+    (
+        I2C_OLED_clip.start_x == 0 && I2C_OLED_clip.end_x == I2C_OLED_logical_columns - 1 &&
+        I2C_OLED_clip.start_y == 0 && I2C_OLED_clip.end_y == I2C_OLED_logical_rows - 1,
+        "clip (%d, %d)-(%d, %d) after the pop",
+        I2C_OLED_clip.start_x, I2C_OLED_clip.start_y, I2C_OLED_clip.end_x, I2C_OLED_clip.end_y
+    );
+    
+    I2C_OLED_SetRotation(I2C_OLED_ROTATION_0);
+    I2C_OLED_ResetClip();
+}
+
+// Time-sliced flush: no step sends more than its budget, the finished flush shows the buffer //
+
+static int budget_overruns = 0;
+static int budget_minimum_sends = 0;
+
+// Runs a started flush to the end with random budgets, false if it does not finish //
+
+static bool Check_FlushSteps(const uint8_t *shown)
+{
+    for (int step = 0; step < 100000; step++)
+    {
+        uint16_t budget = rand() % 60;
+        uint32_t wire_bytes = null_hal_wire_bytes;
+        
+        bool done = I2C_OLED_FlushStep(budget);
+        
+        uint32_t sent = null_hal_wire_bytes - wire_bytes;
+        
+        if (sent > budget)
+            budget_overruns++;
+        // Below the minimum only a deferred flip fits //
+        
+        if (budget < I2C_OLED_FLUSH_STEP_MIN_BUDGET && sent > 0 && !(done && sent == I2C_OLED_FLUSH_FLIP_BYTES))
+            budget_minimum_sends++;
+        
+        if (done)
+            return true;
+        
+        // Double buffering: the panel keeps the previous frame until the flip //
+        
+        if (shown != NULL && Check_PanelChanged(shown))
+            return false;
+    }
+    
+    return false;
+}
+
+static void Check_FlushStep(void)
+{
+    printf("flush step: random budgets, full and partial flushes in every rotation\n");
+    
+    budget_overruns = 0;
+    budget_minimum_sends = 0;
+    
+    for (int rotation = I2C_OLED_ROTATION_0; rotation <= I2C_OLED_ROTATION_270; rotation++)
+    {
+        I2C_OLED_SetRotation(rotation);
+        
+        Check_RandomizeBuffer();
+        I2C_OLED_Update();
+        
+        int differences = 0;
+        
+        for (int i = 0; i < CHECK_ITERATIONS && differences == 0; i++)
+        {
+            uint8_t start_column, end_column, start_page, end_page;
+            
+            Check_RandomRegion(&start_column, &end_column, &start_page, &end_page);
+            
+            // Only the region changes, so the finished flush must show the whole buffer //
+            
+            uint8_t low_column = start_column < end_column ? start_column : end_column;
+            uint8_t high_column = start_column < end_column ? end_column : start_column;
+            uint8_t low_page = start_page < end_page ? start_page : end_page;
+            uint8_t high_page = start_page < end_page ? end_page : start_page;
+            
+            for (uint8_t page = low_page; page <= high_page; page++)
+                for (uint8_t column = low_column; column <= high_column; column++)
+                    I2C_OLED_buffer[(page * I2C_OLED_logical_columns) + column] = rand();
+            
+            if (i % 4 == 0)
+                I2C_OLED_FlushBegin();
+            else
+                I2C_OLED_FlushBeginPartially(start_column, end_column, start_page, end_page);
+            
+            CHECK_EXPECT(Check_FlushSteps(NULL), "rotation %d, flush did not finish", rotation);
+            
+            differences = Check_PanelDifferences();
+            
+            CHECK_EXPECT(differences == 0, "rotation %d, FlushStep: %d pixels differ", rotation, differences);
+        }
+    }
+    
+    CHECK_EXPECT(budget_overruns == 0, "%d steps sent more than their budget", budget_overruns);
+    CHECK_EXPECT(budget_minimum_sends == 0, "%d steps below I2C_OLED_FLUSH_STEP_MIN_BUDGET sent data", budget_minimum_sends);
+    
+    I2C_OLED_SetRotation(I2C_OLED_ROTATION_0);
+}
+
+#if I2C_OLED_PANEL_ROWS == 32
+
+// Double buffering: drawing and a stepped flush never show on the panel before the flip, the flip is in the budget //
+
+static void Check_PanelSnapshot(uint8_t *out_shown)
+{
+    for (uint8_t y = 0; y < I2C_OLED_ROWS; y++)
+        for (uint8_t x = 0; x < I2C_OLED_COLUMNS; x++)
+            out_shown[(y * I2C_OLED_COLUMNS) + x] = SSD1306_Model_GetPixel(x, y);
+}
+
+static void Check_DoubleBuffer(void)
+{
+    printf("double buffer: the panel changes only at the flip, the flip stays within the budget\n");
+    
+    static uint8_t shown[I2C_OLED_COLUMNS * I2C_OLED_ROWS];
+    
+    budget_overruns = 0;
+    budget_minimum_sends = 0;
+    
+    for (int rotation = I2C_OLED_ROTATION_0; rotation <= I2C_OLED_ROTATION_270; rotation++)
+    {
+        I2C_OLED_SetRotation(rotation);
+        
+        CHECK_EXPECT(I2C_OLED_SetDoubleBuffer(true), "double buffering refused");
+        
+        Check_RandomizeBuffer();
+        I2C_OLED_Update();
+        
+        int differences = Check_PanelDifferences();
+        
+        CHECK_EXPECT(differences == 0, "rotation %d, Update: %d pixels differ", rotation, differences);
+        
+        for (int i = 0; i < CHECK_ITERATIONS && differences == 0; i++)
+        {
+            Check_PanelSnapshot(shown);
+            
+            I2C_OLED_FillRect(rand() % 150 - 10, rand() % 150 - 10, rand() % 150 - 10, rand() % 150 - 10, rand() & 1);
+            
+            CHECK_EXPECT(!Check_PanelChanged(shown), "rotation %d, drawing reached the panel before the flip", rotation);
+            
+            I2C_OLED_Rect dirty = I2C_OLED_dirty;
+            
+            if (i % 2 == 0 || dirty.start_x > dirty.end_x)
+            {
+                I2C_OLED_UpdateDirty();
+            }
+            else
+            {
+                I2C_OLED_dirty = (I2C_OLED_Rect){ 0, 0, -1, -1 };
+                I2C_OLED_FlushBeginPartially(dirty.start_x, dirty.end_x, dirty.start_y / 8, dirty.end_y / 8);
+                
+                CHECK_EXPECT(Check_FlushSteps(shown), "rotation %d, stepped flush showed before the flip or did not finish", rotation);
+            }
+            
+            differences = Check_PanelDifferences();
+            
+            CHECK_EXPECT(differences == 0, "rotation %d, after the flip: %d pixels differ", rotation, differences);
+        }
+        
+        I2C_OLED_SetDoubleBuffer(false);
+    }
+    
+    CHECK_EXPECT(budget_overruns == 0, "%d steps sent more than their budget", budget_overruns);
+    CHECK_EXPECT(budget_minimum_sends == 0, "%d steps below I2C_OLED_FLUSH_STEP_MIN_BUDGET sent data", budget_minimum_sends);
+    
+    I2C_OLED_SetRotation(I2C_OLED_ROTATION_0);
+}
+
+#endif
+
+// Clip stack: nested clips and drawing against a per-pixel reference //
+
+static uint8_t reference[I2C_OLED_BUFFER_SIZE];
+static I2C_OLED_ClipRect reference_clip;
+
+static void Check_ReferencePixel(int16_t x, int16_t y, bool set)
+{
+    x += reference_clip.origin_x;
+    y += reference_clip.origin_y;
+    
+    if (x < reference_clip.start_x || x > reference_clip.end_x || y < reference_clip.start_y || y > reference_clip.end_y)
+        return;
+    if (x < 0 || x >= I2C_OLED_logical_columns || y < 0 || y >= I2C_OLED_logical_rows)
+        return;
+    
+    uint8_t *byte = &reference[((y >> 3) * I2C_OLED_logical_columns) + x];
+    
+    if (set)
+        *byte |= 1 << (y & 7);
+    else
+        *byte &= ~(1 << (y & 7));
+}
+
+static void Check_Sort(int16_t *a, int16_t *b)
+{
+    if (*a > *b)
+    {
+        int16_t temp = *a;
+        *a = *b;
+        *b = temp;
+    }
+}
+
+static void Check_ReferencePushClip(int16_t start_x, int16_t start_y, int16_t end_x, int16_t end_y)
+{
+    Check_Sort(&start_x, &end_x);
+    Check_Sort(&start_y, &end_y);
+    
+    start_x += reference_clip.origin_x;
+    end_x += reference_clip.origin_x;
+    start_y += reference_clip.origin_y;
+    end_y += reference_clip.origin_y;
+    
+    reference_clip.origin_x = start_x;
+    reference_clip.origin_y = start_y;
+    
+    if (start_x > reference_clip.start_x)
+        reference_clip.start_x = start_x;
+    if (start_y > reference_clip.start_y)
+        reference_clip.start_y = start_y;
+    if (end_x < reference_clip.end_x)
+        reference_clip.end_x = end_x;
+    if (end_y < reference_clip.end_y)
+        reference_clip.end_y = end_y;
+}
+
+static void Check_Clip(void)
+{
+    printf("clip: nested clips, fills, rectangles and glyphs against a per-pixel reference\n");
+    
+    int mismatches = 0;
+    
+    for (int rotation = I2C_OLED_ROTATION_0; rotation <= I2C_OLED_ROTATION_270; rotation++)
+    {
+        I2C_OLED_SetRotation(rotation);
+        I2C_OLED_manual_update = true;
+        
+        for (int i = 0; i < CHECK_ITERATIONS * 10; i++)
+        {
+            Check_RandomizeBuffer();
+            memcpy(reference, I2C_OLED_buffer, sizeof(reference));
+            
+            I2C_OLED_ResetClip();
+            reference_clip = I2C_OLED_clip;
+            
+            int depth = rand() % (I2C_OLED_CLIP_STACK_DEPTH + 1);
+            
+            for (int level = 0; level < depth; level++)
+            {
+                int16_t start_x = rand() % 100 - 10, start_y = rand() % 100 - 10;
+                int16_t end_x = rand() % 140 - 10, end_y = rand() % 140 - 10;
+                
+                I2C_OLED_PushClip(start_x, start_y, end_x, end_y);
+                Check_ReferencePushClip(start_x, start_y, end_x, end_y);
+            }
+            
+            int16_t start_x = rand() % 160 - 16, start_y = rand() % 160 - 16;
+            int16_t end_x = rand() % 160 - 16, end_y = rand() % 160 - 16;
+            bool inverted = rand() & 1;
+            int operation = rand() % 3;
+            
+            if (operation == 0)
+            {
+                I2C_OLED_FillRect(start_x, start_y, end_x, end_y, inverted);
+                
+                Check_Sort(&start_x, &end_x);
+                Check_Sort(&start_y, &end_y);
+                
+                for (int16_t y = start_y; y <= end_y; y++)
+                    for (int16_t x = start_x; x <= end_x; x++)
+                        Check_ReferencePixel(x, y, !inverted);
+            }
+            else if (operation == 1)
+            {
+                I2C_OLED_DrawRect(start_x, start_y, end_x, end_y, inverted);
+                
+                Check_Sort(&start_x, &end_x);
+                Check_Sort(&start_y, &end_y);
+                
+                for (int16_t y = start_y; y <= end_y; y++)
+                {
+                    for (int16_t x = start_x; x <= end_x; x++)
+                    {
+                        if (x == start_x || x == end_x || y == start_y || y == end_y)
+                            Check_ReferencePixel(x, y, !inverted);
+                    }
+                }
+            }
+            else
+            {
+                char character = 0x20 + rand() % 95;
+                
+                I2C_OLED_PutCharXY(character, start_x, start_y, inverted);
+                
+                for (int16_t column = 0; column < 5; column++)
+                {
+                    for (int16_t row = 0; row < 8; row++)
+                    {
+                        if ((Font_VertHorz_ascii[character - 0x20][column] >> row) & 1)
+                            Check_ReferencePixel(start_x + column, start_y + row, !inverted);
+                    }
+                }
+            }
+            
+            if (memcmp(reference, I2C_OLED_buffer, sizeof(reference)) != 0)
+                mismatches++;
+        }
+        
+        // What the clipped drawing left dirty reaches the panel //
+        
+        I2C_OLED_Update();
+        I2C_OLED_dirty = (I2C_OLED_Rect){ 0, 0, -1, -1 };
+        I2C_OLED_FillRect(-20, -20, 200, 200, false);
+        I2C_OLED_UpdateDirty();
+        
+        int differences = Check_PanelDifferences();
+        
+        CHECK_EXPECT(differences == 0, "rotation %d, clipped fill: %d pixels differ", rotation, differences);
+    }
+    
+    CHECK_EXPECT(mismatches == 0, "%d of %d clipped draws differ from the reference", mismatches, CHECK_ITERATIONS * 10 * 4);
+    
+    I2C_OLED_manual_update = false;
+    I2C_OLED_ResetClip();
+    I2C_OLED_SetRotation(I2C_OLED_ROTATION_0);
+}
+
+int main(void)
+{
+    srand(1);
+    
+    printf("%d x %d panel\n", I2C_OLED_COLUMNS, I2C_OLED_ROWS);
+    
+    Check_Init();
+    Check_Rotation();
+    Check_RotationClip();
+    Check_Clip();
+    Check_FlushStep();
+    
+#if I2C_OLED_PANEL_ROWS == 32
+    Check_DoubleBuffer();
+#endif
+    
+    printf(failures == 0 ? "all model checks passed\n" : "%d failure(s)\n", failures);
+    
+    return failures == 0 ? 0 : 1;
+}
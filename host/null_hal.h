@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef __NULL_HAL_H__
+#define __NULL_HAL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+    Host stand-in for the STM32 HAL, selected with
+    -DI2C_OLED_HAL_HEADER='"null_hal.h"'. Transfers go nowhere, they are
+    only counted (bytes on the wire: slave address, memory address bytes
+    for Mem_Write and Mem_Read, the repeated slave address of Mem_Read,
+    payload) and optionally handed to a hook. Reads return zeros.
+*/
+
+typedef enum
+{
+    HAL_OK      = 0x00,
+    HAL_ERROR   = 0x01,
+    HAL_BUSY    = 0x02,
+    HAL_TIMEOUT = 0x03,
+} HAL_StatusTypeDef;
+
+typedef enum
+{
+    HAL_I2C_STATE_RESET = 0x00,
+    HAL_I2C_STATE_READY = 0x20,
+    HAL_I2C_STATE_BUSY  = 0x24,
+} HAL_I2C_StateTypeDef;
+
+typedef struct
+{
+    uint32_t instance;
+} I2C_HandleTypeDef;
+
+// Counters, reset by the caller //
+extern uint32_t null_hal_transfers;
+extern uint32_t null_hal_wire_bytes;
+
+// HAL_GetTick() value, advanced by HAL_Delay() or the caller //
+extern uint32_t null_hal_tick;
+
+// Returned by HAL_I2C_GetState() //
+extern HAL_I2C_StateTypeDef null_hal_state;
+
+// Called for every transfer with the bytes it put on the wire (NULL: none) //
+extern void (*null_hal_transfer_hook)(const uint8_t *data, uint16_t length, uint16_t wire_bytes);
+
+// Called for every write with its memory address, -1 for Master_Transmit (NULL: none) //
+extern void (*null_hal_write_hook)(int32_t mem_address, const uint8_t *data, uint16_t length);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    
+    extern HAL_StatusTypeDef HAL_I2C_Mem_Write
+    (
+        I2C_HandleTypeDef *hi2c,
+        uint16_t DevAddress,
+        uint16_t MemAddress,
+        uint16_t MemAddSize,
+        uint8_t *pData,
+        uint16_t Size,
+        uint32_t Timeout
+    );
+    extern HAL_StatusTypeDef HAL_I2C_Mem_Read
+    (
+        I2C_HandleTypeDef *hi2c,
+        uint16_t DevAddress,
+        uint16_t MemAddress,
+        uint16_t MemAddSize,
+        uint8_t *pData,
+        uint16_t Size,
+        uint32_t Timeout
+    );
+    extern HAL_StatusTypeDef HAL_I2C_Master_Transmit
+    (
+        I2C_HandleTypeDef *hi2c,
+        uint16_t DevAddress,
+        uint8_t *pData,
+        uint16_t Size,
+        uint32_t Timeout
+    );
+    extern HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef *hi2c);
+    
+    extern uint32_t HAL_GetTick(void);
+    extern void HAL_Delay(uint32_t Delay);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
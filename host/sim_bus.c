@@ -0,0 +1,267 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/*
+    Bus sharing simulation: an IMU signals a new sample every millisecond
+    while the display redraws the whole screen at 30 fps on the same bus.
+    The main loop either calls I2C_OLED_Update() and reads the IMU between
+    frames, or submits both to the bus arbiter (IMU high priority, display
+    low priority in I2C_OLED_BUS_DISPLAY_CHUNK byte chunks).
+    
+    Time is simulated: every transfer the null HAL sees advances the clock
+    by its wire time, a pass of the main loop without a transfer by
+    SIM_LOOP_NS. 100 kHz is left out, the IMU reads alone would fill it.
+    Reported per bus speed and loop:
+        worst, mean     oldest unread data ready to sample read (end of the IMU transfer)
+        missed          samples overwritten by the next one before being read
+        frames          display frames fully sent, of SIM_DURATION_NS / SIM_FRAME_PERIOD_NS drawn
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "I2C_OLED.h"
+#include "I2C_OLED_Bus.h"
+#include "null_hal.h"
+
+#define SIM_DURATION_NS         1000000000ULL
+#define SIM_LOOP_NS             5000ULL
+
+// 8 data bits + ACK per byte, START and STOP about one bit each //
+#define SIM_BITS_PER_BYTE       9
+#define SIM_BITS_PER_TRANSFER   2
+
+// IMU: 1 kHz data ready, accelerometer + gyroscope burst read //
+#define SIM_IMU_ADDR            0xD0
+#define SIM_IMU_SAMPLE_REGISTER 0x3B
+#define SIM_IMU_SAMPLE_BYTES    12
+#define SIM_IMU_PERIOD_NS       1000000ULL
+#define SIM_IMU_PHASE_NS        370000ULL
+
+#define SIM_FRAME_PERIOD_NS     33333333ULL
+
+static const uint32_t sim_bitrates[] = { 400000, 1000000 };
+
+static I2C_HandleTypeDef sim_i2c_handler;
+
+static uint64_t sim_now_ns;
+static uint32_t sim_bitrate;
+
+typedef struct
+{
+    uint64_t next_ready_ns;
+    uint64_t ready_ns;
+    bool sample_pending;
+    
+    uint64_t worst_ns;
+    uint64_t total_ns;
+    uint32_t reads;
+    uint32_t missed;
+} Sim_Imu;
+
+static Sim_Imu imu;
+static I2C_OLED_BusRequest imu_request;
+
+// Clock //
+
+static void Sim_TransferHook(const uint8_t *data, uint16_t length, uint16_t wire_bytes)
+{
+    (void)data;
+    (void)length;
+    
+    uint64_t bits = ((uint64_t)wire_bytes * SIM_BITS_PER_BYTE) + SIM_BITS_PER_TRANSFER;
+    
+    sim_now_ns += (bits * 1000000000ULL) / sim_bitrate;
+    null_hal_tick = sim_now_ns / 1000000;
+}
+
+// IMU //
+
+static bool Sim_ImuRead(void *argument)
+{
+    (void)argument;
+    
+    uint8_t sample[SIM_IMU_SAMPLE_BYTES];
+    
+    HAL_I2C_Mem_Read(&sim_i2c_handler, SIM_IMU_ADDR, SIM_IMU_SAMPLE_REGISTER, 1, sample, sizeof(sample), 10);
+    
+    uint64_t latency = sim_now_ns - imu.ready_ns;
+    
+    if (latency > imu.worst_ns)
+        imu.worst_ns = latency;
+    
+    imu.total_ns += latency;
+    imu.reads++;
+    imu.sample_pending = false;
+    
+    return true;
+}
+
+// Data ready interrupts up to now, each one replaces an unread sample //
+
+static void Sim_ImuInterrupts(bool arbiter)
+{
+    while (sim_now_ns >= imu.next_ready_ns)
+    {
+        if (imu.sample_pending)
+        {
+            imu.missed++;
+        }
+        else
+        {
+            imu.ready_ns = imu.next_ready_ns;
+            imu.sample_pending = true;
+            
+            if (arbiter)
+                I2C_OLED_Bus_Submit(&imu_request);
+        }
+        
+        imu.next_ready_ns += SIM_IMU_PERIOD_NS;
+    }
+}
+
+// Display //
+
+static void Sim_DrawFrame(uint32_t frame)
+{
+    // Every byte changes, so every frame is a full refresh //
+    
+    I2C_OLED_FillRect(0, 0, I2C_OLED_logical_columns - 1, I2C_OLED_logical_rows - 1, (frame & 1) != 0);
+}
+
+// Drawing while a flush is half sent must still reach the panel without another submit //
+
+static bool Sim_DrawDuringFlush(void)
+{
+    sim_bitrate = sim_bitrates[0];
+    
+    I2C_OLED_Bus_RegisterDisplay(I2C_OLED_BUS_PRIORITY_LOW, I2C_OLED_BUS_DISPLAY_CHUNK);
+    
+    I2C_OLED_FillRect(0, 0, I2C_OLED_logical_columns - 1, I2C_OLED_logical_rows - 1, true);
+    I2C_OLED_Bus_SubmitDisplay();
+    
+    for (int i = 0; i < 4; i++)
+        I2C_OLED_Bus_Poll();
+    
+    bool flush_busy = I2C_OLED_FlushBusy();
+    
+    I2C_OLED_FillRect(10, 10, 20, 20, false);
+    I2C_OLED_Bus_SubmitDisplay();
+    
+    uint32_t polls = 0;
+    
+    while (I2C_OLED_Bus_Poll() && polls < 100000)
+        polls++;
+    
+    bool clean = I2C_OLED_dirty.start_x > I2C_OLED_dirty.end_x;
+    
+    printf("draw during flush: %s\n\n", (flush_busy && clean) ? "sent" : "FAILED, dirty area left after the bus went idle");
+    
+    return flush_busy && clean;
+}
+
+// Run //
+
+static void Sim_Run(uint32_t bitrate, bool arbiter)
+{
+    sim_bitrate = bitrate;
+    sim_now_ns = 0;
+    null_hal_tick = 0;
+    
+    imu = (Sim_Imu){ .next_ready_ns = SIM_IMU_PHASE_NS };
+    
+    uint64_t next_frame_ns = 0;
+    uint32_t frames_drawn = 0;
+    uint32_t frames_sent = 0;
+    
+    if (arbiter)
+    {
+        I2C_OLED_Bus_Register(&imu_request, Sim_ImuRead, NULL, I2C_OLED_BUS_PRIORITY_HIGH);
+        I2C_OLED_Bus_RegisterDisplay(I2C_OLED_BUS_PRIORITY_LOW, I2C_OLED_BUS_DISPLAY_CHUNK);
+    }
+    
+    while (sim_now_ns < SIM_DURATION_NS)
+    {
+        uint32_t transfers = null_hal_transfers;
+        
+        if (sim_now_ns >= next_frame_ns)
+        {
+            Sim_DrawFrame(frames_drawn++);
+            next_frame_ns += SIM_FRAME_PERIOD_NS;
+            
+            if (arbiter)
+            {
+                I2C_OLED_Bus_SubmitDisplay();
+            }
+            else
+            {
+                I2C_OLED_Update();
+                frames_sent++;
+            }
+        }
+        
+        Sim_ImuInterrupts(arbiter);
+        
+        if (arbiter)
+        {
+            bool flush_busy = I2C_OLED_FlushBusy();
+            
+            I2C_OLED_Bus_Poll();
+            
+            if (flush_busy && !I2C_OLED_FlushBusy())
+                frames_sent++;
+        }
+        else if (imu.sample_pending)
+        {
+            Sim_ImuRead(NULL);
+        }
+        
+        if (null_hal_transfers == transfers)
+            sim_now_ns += SIM_LOOP_NS;
+    }
+    
+    // Leave nothing queued for the next run //
+    
+    while (I2C_OLED_Bus_Poll());
+    
+    printf
+    (
+        "%7lu kHz  %-9s %9.2f ms %9.2f ms %8lu %8lu / %lu\n",
+        (unsigned long)(bitrate / 1000),
+        arbiter ? "arbiter" : "blocking",
+        imu.worst_ns / 1e6,
+        imu.reads > 0 ? (imu.total_ns / imu.reads) / 1e6 : 0.0,
+        (unsigned long)imu.missed,
+        (unsigned long)frames_sent,
+        (unsigned long)frames_drawn
+    );
+}
+
+int main(void)
+{
+    I2C_OLED_Initialize(&sim_i2c_handler);
+    I2C_OLED_manual_update = true;
+    
+    null_hal_transfer_hook = Sim_TransferHook;
+    
+    printf
+    (
+        "IMU read every %.1f ms (%d bytes), full-screen redraw at 30 fps, display chunks of %d bytes, %.1f s simulated\n\n",
+        SIM_IMU_PERIOD_NS / 1e6,
+        SIM_IMU_SAMPLE_BYTES,
+        I2C_OLED_BUS_DISPLAY_CHUNK,
+        SIM_DURATION_NS / 1e9
+    );
+    if (!Sim_DrawDuringFlush())
+        return 1;
+    
+    printf("    bus      loop          worst IMU      mean IMU   missed   frames\n");
+    
+    for (size_t i = 0; i < sizeof(sim_bitrates) / sizeof(sim_bitrates[0]); i++)
+    {
+        Sim_Run(sim_bitrates[i], false);
+        Sim_Run(sim_bitrates[i], true);
+    }
+    
+    return 0;
+}
@@ -0,0 +1,257 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "ssd1306_model.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "null_hal.h"
+
+SSD1306_Model ssd1306_model;
+
+// Control byte: Co (another control byte follows the next byte) and D/C# //
+#define SSD1306_MODEL_CONTROL_CO    0x80
+#define SSD1306_MODEL_CONTROL_DATA  0x40
+
+static uint8_t SSD1306_Model_ArgumentsNeeded(uint8_t opcode)
+{
+    switch (opcode)
+    {
+        case 0x20:
+        case 0x81:
+        case 0x8D:
+        case 0xA8:
+        case 0xD3:
+        case 0xD5:
+        case 0xD9:
+        case 0xDA:
+        case 0xDB:
+            return 1;
+        case 0x21:
+        case 0x22:
+        case 0xA3:
+            return 2;
+        case 0x29:
+        case 0x2A:
+            return 5;
+        case 0x26:
+        case 0x27:
+            return 6;
+        case 0x2C:
+        case 0x2D:
+            return 7;
+        default:
+            return 0;
+    }
+}
+
+static void SSD1306_Model_Execute(void)
+{
+    SSD1306_Model *model = &ssd1306_model;
+    uint8_t opcode = model->opcode;
+    const uint8_t *arguments = model->arguments;
+    
+    bool page_mode = model->mode == SSD1306_MODEL_PAGE;
+    
+    if (opcode <= 0x0F || (opcode >= 0xB0 && opcode <= 0xB7) || (opcode >= 0x10 && opcode <= 0x1F))
+    {
+        if (!page_mode)
+        {
+            model->ignored_commands++;
+            return;
+        }
+        
+        if (opcode <= 0x0F)
+            model->column = (model->column & 0xF0) | opcode;
+        else if (opcode <= 0x1F)
+            model->column = (model->column & 0x0F) | ((opcode & 0x07) << 4);
+        else
+            model->page = opcode & 0x07;
+        
+        return;
+    }
+    
+    if (opcode == 0x21 || opcode == 0x22)
+    {
+        if (page_mode)
+        {
+            model->ignored_commands++;
+            return;
+        }
+        
+        if (opcode == 0x21)
+        {
+            model->column_start = arguments[0] & 0x7F;
+            model->column_end = arguments[1] & 0x7F;
+            model->column = model->column_start;
+        }
+        else
+        {
+            model->page_start = arguments[0] & 0x07;
+            model->page_end = arguments[1] & 0x07;
+            model->page = model->page_start;
+        }
+        
+        return;
+    }
+    
+    if (opcode >= 0x40 && opcode <= 0x7F)
+    {
+        model->start_line = opcode & 0x3F;
+        return;
+    }
+    
+    switch (opcode)
+    {
+        case 0x20:
+            if ((arguments[0] & 0x03) != 0x03)
+                model->mode = (SSD1306_ModelMode)(arguments[0] & 0x03);
+            break;
+        
+        case 0xA8:
+            if ((arguments[0] & 0x3F) >= 15)
+                model->multiplex = (arguments[0] & 0x3F) + 1;
+            break;
+        
+        case 0xA0:
+        case 0xA1:
+            model->segment_remap = opcode == 0xA1;
+            break;
+        
+        case 0xC0:
+        case 0xC8:
+            model->com_remap = opcode == 0xC8;
+            break;
+        
+        case 0xAE:
+        case 0xAF:
+            model->display_on = opcode == 0xAF;
+            break;
+        
+        default:
+            break;
+    }
+}
+
+static void SSD1306_Model_Command(uint8_t byte)
+{
+    SSD1306_Model *model = &ssd1306_model;
+    
+    if (model->arguments_needed > 0)
+    {
+        model->arguments[model->argument_count++] = byte;
+        
+        if (model->argument_count < model->arguments_needed)
+            return;
+        
+        model->arguments_needed = 0;
+        SSD1306_Model_Execute();
+        return;
+    }
+    
+    model->opcode = byte;
+    model->argument_count = 0;
+    model->arguments_needed = SSD1306_Model_ArgumentsNeeded(byte);
+    
+    if (model->arguments_needed == 0)
+        SSD1306_Model_Execute();
+}
+
+static void SSD1306_Model_Data(uint8_t byte)
+{
+    SSD1306_Model *model = &ssd1306_model;
+    
+    model->ram[model->page][model->column] = byte;
+    
+    // Page addressing wraps to column 0 of the same page //
+    
+    if (model->mode == SSD1306_MODEL_PAGE)
+    {
+        model->column = (model->column + 1) % SSD1306_MODEL_COLUMNS;
+        return;
+    }
+    
+    if (model->mode == SSD1306_MODEL_VERTICAL)
+    {
+        if (model->page < model->page_end)
+        {
+            model->page++;
+            return;
+        }
+        
+        model->page = model->page_start;
+        model->column = (model->column < model->column_end) ? model->column + 1 : model->column_start;
+        return;
+    }
+    
+    if (model->column < model->column_end)
+    {
+        model->column++;
+        return;
+    }
+    
+    model->column = model->column_start;
+    model->page = (model->page < model->page_end) ? model->page + 1 : model->page_start;
+}
+
+static void SSD1306_Model_Stream(uint8_t control, const uint8_t *data, uint16_t length)
+{
+    for (uint16_t i = 0; i < length; i++)
+    {
+        if (control & SSD1306_MODEL_CONTROL_DATA)
+            SSD1306_Model_Data(data[i]);
+        else
+            SSD1306_Model_Command(data[i]);
+    }
+}
+
+// Mem_Write sends its memory address as the control byte, Master_Transmit starts with one //
+
+static void SSD1306_Model_Write(int32_t mem_address, const uint8_t *data, uint16_t length)
+{
+    if (mem_address >= 0)
+    {
+        SSD1306_Model_Stream((uint8_t)mem_address, data, length);
+        return;
+    }
+    
+    uint16_t i = 0;
+    
+    while (i < length)
+    {
+        uint8_t control = data[i++];
+        
+        if ((control & SSD1306_MODEL_CONTROL_CO) == 0)
+        {
+            SSD1306_Model_Stream(control, data + i, length - i);
+            return;
+        }
+        
+        if (i < length)
+            SSD1306_Model_Stream(control, data + i++, 1);
+    }
+}
+
+void SSD1306_Model_Reset(void)
+{
+    memset(&ssd1306_model, 0, sizeof(ssd1306_model));
+    
+    ssd1306_model.mode = SSD1306_MODEL_PAGE;
+    ssd1306_model.column_end = SSD1306_MODEL_COLUMNS - 1;
+    ssd1306_model.page_end = SSD1306_MODEL_PAGES - 1;
+    ssd1306_model.multiplex = 64;
+    
+    null_hal_write_hook = SSD1306_Model_Write;
+}
+
+bool SSD1306_Model_GetPixel(uint8_t x, uint8_t y)
+{
+    const SSD1306_Model *model = &ssd1306_model;
+    
+    uint8_t column = model->segment_remap ? x : (SSD1306_MODEL_COLUMNS - 1) - x;
+    uint8_t com = model->com_remap ? y : (model->multiplex - 1) - y;
+    uint8_t row = (model->start_line + com) & 0x3F;
+    
+    return (model->ram[row >> 3][column] >> (row & 7)) & 1;
+}
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef __SSD1306_MODEL_H__
+#define __SSD1306_MODEL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+    SSD1306 model for the host checks: fed by the null HAL write hook, it
+    keeps GDDRAM, the RAM pointer and the display settings the driver
+    uses. Addressing follows the datasheet strictly: page start (B0h-B7h)
+    and column nibbles (00h-1Fh) only act in page addressing mode, column
+    and page windows (21h, 22h) only in horizontal and vertical mode.
+*/
+
+#define SSD1306_MODEL_COLUMNS   128
+#define SSD1306_MODEL_PAGES     8
+
+typedef enum
+{
+    SSD1306_MODEL_HORIZONTAL = 0,
+    SSD1306_MODEL_VERTICAL = 1,
+    SSD1306_MODEL_PAGE = 2,
+} SSD1306_ModelMode;
+
+typedef struct
+{
+    uint8_t ram[SSD1306_MODEL_PAGES][SSD1306_MODEL_COLUMNS];
+    
+    SSD1306_ModelMode mode;
+    uint8_t page, column;
+    uint8_t column_start, column_end;
+    uint8_t page_start, page_end;
+    
+    uint8_t start_line;
+    uint8_t multiplex;          // Rows driven, A8h argument + 1
+    bool segment_remap;         // A1h
+    bool com_remap;             // C8h
+    bool display_on;
+    
+    // Page addressing commands received outside page mode, and the other way round //
+    uint32_t ignored_commands;
+    
+    // Command being collected //
+    uint8_t opcode;
+    uint8_t arguments[8];
+    uint8_t argument_count;
+    uint8_t arguments_needed;
+} SSD1306_Model;
+
+extern SSD1306_Model ssd1306_model;
+
+// Power-on reset state (page addressing, start line 0, 64 rows), attached to the null HAL //
+extern void SSD1306_Model_Reset(void);
+
+/*
+    Pixel seen at panel position (x, y), y below the multiplex ratio, on a
+    module mounted the usual way: upright with A1h and C8h.
+*/
+extern bool SSD1306_Model_GetPixel(uint8_t x, uint8_t y);
+
+#endif
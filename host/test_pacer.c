@@ -0,0 +1,260 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/*
+    Frame pacer tests on a simulated clock: every transfer the null HAL
+    sees advances it by its wire time, a poll without a transfer by
+    TEST_LOOP_US. The main loop draws and submits a frame every
+    submit_period_us and polls in between.
+    
+    Exit status 0 when every test passed.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "I2C_OLED.h"
+#include "I2C_OLED_FramePacer.h"
+#include "null_hal.h"
+
+#define TEST_LOOP_US            100
+#define TEST_DURATION_US        1000000
+
+// 8 data bits + ACK per byte, START and STOP about one bit each //
+#define TEST_BITS_PER_BYTE      9
+#define TEST_BITS_PER_TRANSFER  2
+
+#define TEST_MAX_FRAMES         64
+
+static int failures = 0;
+
+#define TEST_EXPECT(condition, ...)                                 \
+    do                                                              \
+    {                                                               \
+        if (!(condition))                                           \
+        {                                                           \
+            printf("  FAIL %s:%d: ", __FILE__, __LINE__);           \
+            printf(__VA_ARGS__);                                    \
+            printf("\n");                                           \
+            failures++;                                             \
+        }                                                           \
+    } while (0)
+
+// Clock //
+
+static uint64_t now_us;
+static uint32_t bitrate;
+
+static void Test_TransferHook(const uint8_t *data, uint16_t length, uint16_t wire_bytes)
+{
+    (void)data;
+    (void)length;
+    
+    uint64_t bits = ((uint64_t)wire_bytes * TEST_BITS_PER_BYTE) + TEST_BITS_PER_TRANSFER;
+    
+    now_us += (bits * 1000000) / bitrate;
+}
+
+static uint32_t Test_GetTick(void)
+{
+    return (uint32_t)(now_us / 1000);
+}
+
+// Blocking flush function of a fixed length //
+
+static void Test_BlockingFlush(void)
+{
+    now_us += 10000;
+}
+
+// Run //
+
+typedef struct
+{
+    uint32_t submitted;
+    uint32_t start_tick[TEST_MAX_FRAMES];
+    uint32_t end_tick[TEST_MAX_FRAMES];
+    uint32_t busy_polls;            // Polls that returned with the frame still on the bus
+} Test_Run;
+
+static void Test_Pace
+(
+    Test_Run *run,
+    I2C_OLED_FramePacer *pacer,
+    uint32_t bus_bitrate,
+    uint32_t submit_period_us,
+    void (*flush)(void)
+)
+{
+    *run = (Test_Run){ 0 };
+    
+    bitrate = bus_bitrate;
+    now_us = 0;
+    
+    I2C_OLED_FramePacer_Initialize(pacer, 30, Test_GetTick, flush);
+    
+    uint64_t next_submit_us = 0;
+    
+    while (now_us < TEST_DURATION_US)
+    {
+        uint32_t transfers = null_hal_transfers;
+        
+        if (now_us >= next_submit_us)
+        {
+            I2C_OLED_FramePacer_SubmitFrame(pacer);
+            run->submitted++;
+            next_submit_us += submit_period_us;
+        }
+        
+        uint32_t frame = pacer->frames_presented;
+        
+        if (I2C_OLED_FramePacer_Poll(pacer))
+        {
+            if (frame < TEST_MAX_FRAMES)
+            {
+                run->start_tick[frame] = pacer->flush_start_tick;
+                run->end_tick[frame] = Test_GetTick();
+            }
+        }
+        else if (I2C_OLED_FlushBusy())
+        {
+            run->busy_polls++;
+        }
+        
+        if (null_hal_transfers == transfers)
+            now_us += TEST_LOOP_US;
+    }
+    
+    // Finish the frame on the bus, it is not counted //
+    
+    while (I2C_OLED_FlushBusy())
+        I2C_OLED_FlushStep(I2C_OLED_FLUSH_STEP_MIN_BUDGET);
+}
+
+// Drop counting: every submit is presented, dropped or still pending //
+
+static void Test_ExpectAccounted(const Test_Run *run, const I2C_OLED_FramePacer *pacer)
+{
+    uint32_t accounted = pacer->frames_presented + pacer->frames_dropped + (pacer->frame_pending ? 1 : 0) + (pacer->frame_in_flight ? 1 : 0);
+    
+    TEST_EXPECT
+    (
+        accounted == run->submitted,
+        "%u submitted, %u presented + %u dropped + %u waiting",
+        run->submitted,
+        pacer->frames_presented,
+        pacer->frames_dropped,
+        accounted - pacer->frames_presented - pacer->frames_dropped
+    );
+}
+
+// 400 kHz, a full frame fits a 33 ms slot: frames start on the grid and are sent over many polls //
+
+static void Test_Grid(void)
+{
+    printf("grid: 30 fps at 400 kHz, a frame drawn every 5 ms\n");
+    
+    static I2C_OLED_FramePacer pacer;
+    static Test_Run run;
+    
+    Test_Pace(&run, &pacer, 400000, 5000, NULL);
+    
+    TEST_EXPECT(pacer.frames_presented == 30, "%u frames presented", pacer.frames_presented);
+    
+    for (uint32_t i = 0; i < pacer.frames_presented && i < TEST_MAX_FRAMES; i++)
+    {
+        uint32_t slot = (i * 1000) / 30;
+        
+        TEST_EXPECT(run.start_tick[i] == slot, "frame %u started at %u ms, slot is %u ms", i, run.start_tick[i], slot);
+    }
+    
+    // A frame was in flight across polls, the main loop kept running //
+    
+    TEST_EXPECT(run.busy_polls >= pacer.frames_presented * 10, "only %u polls while a frame was on the bus", run.busy_polls);
+    
+    // 6 or 7 frames drawn per slot, the newest is sent and the others drop //
+    
+    TEST_EXPECT(pacer.frames_dropped > pacer.frames_presented * 5, "%u dropped", pacer.frames_dropped);
+    
+    Test_ExpectAccounted(&run, &pacer);
+    
+    printf("  %u presented, %u dropped, %u polls while sending, last flush %u ms\n", pacer.frames_presented, pacer.frames_dropped, run.busy_polls, pacer.last_flush_duration);
+}
+
+// 100 kHz, a full frame in 40-byte steps takes about 117 ms: missed slots are skipped, no burst to catch up //
+
+static void Test_Overrun(void)
+{
+    printf("overrun: 30 fps at 100 kHz\n");
+    
+    static I2C_OLED_FramePacer pacer;
+    static Test_Run run;
+    
+    Test_Pace(&run, &pacer, 100000, 5000, NULL);
+    
+    TEST_EXPECT(pacer.frames_presented >= 7 && pacer.frames_presented <= 9, "%u frames presented", pacer.frames_presented);
+    
+    for (uint32_t i = 1; i < pacer.frames_presented && i < TEST_MAX_FRAMES; i++)
+    {
+        TEST_EXPECT(run.start_tick[i] >= run.end_tick[i - 1], "frame %u started at %u ms, before frame %u ended at %u ms", i, run.start_tick[i], i - 1, run.end_tick[i - 1]);
+        TEST_EXPECT(run.start_tick[i] - run.start_tick[i - 1] >= 33, "frames %u and %u only %u ms apart", i - 1, i, run.start_tick[i] - run.start_tick[i - 1]);
+    }
+    
+    Test_ExpectAccounted(&run, &pacer);
+    
+    printf("  %u presented, %u dropped, last flush %u ms\n", pacer.frames_presented, pacer.frames_dropped, pacer.last_flush_duration);
+}
+
+// Drawing slower than the target: nothing drops, a frame is sent at the first slot after it is drawn //
+
+static void Test_SlowDrawing(void)
+{
+    printf("slow drawing: 30 fps target, a frame drawn every 50 ms\n");
+    
+    static I2C_OLED_FramePacer pacer;
+    static Test_Run run;
+    
+    Test_Pace(&run, &pacer, 400000, 50000, NULL);
+    
+    TEST_EXPECT(pacer.frames_dropped == 0, "%u dropped", pacer.frames_dropped);
+    TEST_EXPECT(pacer.frames_presented == 20, "%u frames presented", pacer.frames_presented);
+    
+    Test_ExpectAccounted(&run, &pacer);
+}
+
+// Blocking flush function: presented in the poll that starts it //
+
+static void Test_Blocking(void)
+{
+    printf("blocking flush function: 10 ms per frame\n");
+    
+    static I2C_OLED_FramePacer pacer;
+    static Test_Run run;
+    
+    Test_Pace(&run, &pacer, 400000, 5000, Test_BlockingFlush);
+    
+    TEST_EXPECT(pacer.frames_presented == 30, "%u frames presented", pacer.frames_presented);
+    TEST_EXPECT(pacer.last_flush_duration == 10, "last flush %u ms", pacer.last_flush_duration);
+    TEST_EXPECT(run.busy_polls == 0, "%u polls with a frame on the bus", run.busy_polls);
+    
+    Test_ExpectAccounted(&run, &pacer);
+}
+
+int main(void)
+{
+    static I2C_HandleTypeDef i2c_handler;
+    
+    I2C_OLED_Initialize(&i2c_handler);
+    I2C_OLED_manual_update = true;
+    
+    null_hal_transfer_hook = Test_TransferHook;
+    
+    Test_Grid();
+    Test_Overrun();
+    Test_SlowDrawing();
+    Test_Blocking();
+    
+    printf(failures == 0 ? "all pacer tests passed\n" : "%d failure(s)\n", failures);
+    
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,322 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/*
+    Display service stress tests: pthreads stand in for the producer tasks
+    and the ISR, one thread is the display task. Built twice by the
+    Makefile, plainly and with -fsanitize=thread.
+    
+    Exit status 0 when every test passed.
+*/
+
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "I2C_OLED.h"
+#include "I2C_OLED_Service.h"
+#include "I2C_OLED_Atomic.h"
+
+#define TEST_PRODUCERS              4
+#define TEST_COMMANDS_PER_PRODUCER  100000
+
+static int failures = 0;
+
+#define TEST_EXPECT(condition, ...)                                 \
+    do                                                              \
+    {                                                               \
+        if (!(condition))                                           \
+        {                                                           \
+            printf("  FAIL %s:%d: ", __FILE__, __LINE__);           \
+            printf(__VA_ARGS__);                                    \
+            printf("\n");                                           \
+            failures++;                                             \
+        }                                                           \
+    } while (0)
+
+// Display task //
+
+static volatile uint32_t producers_done = 0;
+
+static void *Test_DisplayTask(void *argument)
+{
+    (void)argument;
+    
+    // Drain until every producer is done, then once more for what they left //
+    
+    while (I2C_OLED_Atomic_Load(&producers_done) < TEST_PRODUCERS)
+    {
+        if (I2C_OLED_Service_Drain() == 0)
+            sched_yield();
+    }
+    
+    while (I2C_OLED_Service_Drain() > 0);
+    
+    return NULL;
+}
+
+static void Test_RunThreads(void *(*producer)(void *argument))
+{
+    pthread_t display_thread;
+    pthread_t producer_threads[TEST_PRODUCERS];
+    
+    I2C_OLED_Atomic_Store(&producers_done, 0);
+    
+    pthread_create(&display_thread, NULL, Test_DisplayTask, NULL);
+    
+    for (uintptr_t i = 0; i < TEST_PRODUCERS; i++)
+        pthread_create(&producer_threads[i], NULL, producer, (void *)i);
+    
+    for (int i = 0; i < TEST_PRODUCERS; i++)
+        pthread_join(producer_threads[i], NULL);
+    
+    pthread_join(display_thread, NULL);
+}
+
+// Ordering: every accepted command arrives exactly once, in submit order per producer //
+
+static uint32_t received_count[TEST_PRODUCERS];     // Display task only until joined
+static uint32_t received_next[TEST_PRODUCERS];
+static uint32_t received_out_of_order = 0;
+
+static uint32_t producer_rejected[TEST_PRODUCERS];  // Own producer only until joined
+
+static void Test_OrderCallback(void *argument)
+{
+    uintptr_t value = (uintptr_t)argument;
+    
+    uint32_t producer = value >> 24;
+    uint32_t sequence = value & 0xFFFFFF;
+    
+    if (sequence != received_next[producer])
+        received_out_of_order++;
+    
+    received_next[producer] = sequence + 1;
+    received_count[producer]++;
+}
+
+static void *Test_OrderProducer(void *argument)
+{
+    uintptr_t producer = (uintptr_t)argument;
+    
+    for (uintptr_t sequence = 0; sequence < TEST_COMMANDS_PER_PRODUCER; sequence++)
+    {
+        // A full queue is retried, so every sequence number is eventually accepted //
+        
+        while (!I2C_OLED_Service_Callback(Test_OrderCallback, (void *)((producer << 24) | sequence)))
+        {
+            producer_rejected[producer]++;
+            sched_yield();
+        }
+    }
+    
+    I2C_OLED_Atomic_FetchAdd(&producers_done, 1);
+    
+    return NULL;
+}
+
+static void Test_Ordering(void)
+{
+    printf("ordering: %d producers x %d callbacks\n", TEST_PRODUCERS, TEST_COMMANDS_PER_PRODUCER);
+    
+    I2C_OLED_Service_Initialize();
+    
+    memset(received_count, 0, sizeof(received_count));
+    memset(received_next, 0, sizeof(received_next));
+    memset(producer_rejected, 0, sizeof(producer_rejected));
+    received_out_of_order = 0;
+    
+    Test_RunThreads(Test_OrderProducer);
+    
+    uint32_t rejected = 0;
+    
+    for (int i = 0; i < TEST_PRODUCERS; i++)
+    {
+        TEST_EXPECT(received_count[i] == TEST_COMMANDS_PER_PRODUCER, "producer %d: %u of %u received", i, received_count[i], TEST_COMMANDS_PER_PRODUCER);
+        rejected += producer_rejected[i];
+    }
+    
+    TEST_EXPECT(received_out_of_order == 0, "%u commands out of order", received_out_of_order);
+    TEST_EXPECT(I2C_OLED_Service_GetDropped() == rejected, "dropped %u, producers saw %u rejections", I2C_OLED_Service_GetDropped(), rejected);
+    
+    printf("  %u submits rejected on a full queue and retried\n", rejected);
+}
+
+// Drawing: producers fill their own quadrant, only the display task touches the buffer //
+
+static void *Test_DrawProducer(void *argument)
+{
+    uintptr_t producer = (uintptr_t)argument;
+    
+    int16_t start_x = (producer & 1) * 64;
+    int16_t start_y = (producer >> 1) * 32;
+    
+    for (int i = 0; i < TEST_COMMANDS_PER_PRODUCER / 10; i++)
+    {
+        // Ends on a set fill, clear and set alternate before that //
+        
+        bool inverted = (i & 1) == 0;
+        
+        while (!I2C_OLED_Service_FillRect(start_x, start_y, start_x + 63, start_y + 31, inverted))
+            sched_yield();
+        
+        while (!I2C_OLED_Service_PrintStrXY("stress", start_x + 2, start_y + 2, false))
+            sched_yield();
+    }
+    
+    while (!I2C_OLED_Service_FillRect(start_x, start_y, start_x + 63, start_y + 31, false))
+        sched_yield();
+    
+    I2C_OLED_Atomic_FetchAdd(&producers_done, 1);
+    
+    return NULL;
+}
+
+static void Test_Drawing(void)
+{
+    printf("drawing: %d producers, fill and text commands\n", TEST_PRODUCERS);
+    
+    I2C_OLED_Service_Initialize();
+    I2C_OLED_ClearBuffer();
+    
+    Test_RunThreads(Test_DrawProducer);
+    
+    int cleared = 0;
+    
+    for (int i = 0; i < I2C_OLED_BUFFER_SIZE; i++)
+    {
+        if (I2C_OLED_buffer[i] != 0xFF)
+            cleared++;
+    }
+    
+    TEST_EXPECT(cleared == 0, "%d buffer bytes not set after the final fills", cleared);
+    TEST_EXPECT(I2C_OLED_dirty.start_x > I2C_OLED_dirty.end_x, "dirty area left after the last drain");
+}
+
+// Clipping: every producer fills the whole screen inside its own quadrant clip //
+
+static void *Test_ClipProducer(void *argument)
+{
+    uintptr_t producer = (uintptr_t)argument;
+    
+    I2C_OLED_Command command;
+    
+    command.type = I2C_OLED_COMMAND_FILL_RECT;
+    command.start_x = 0;
+    command.start_y = 0;
+    command.end_x = 127;
+    command.end_y = 63;
+    
+    int16_t start_x = (producer & 1) * 64;
+    int16_t start_y = (producer >> 1) * 32;
+    
+    I2C_OLED_Service_ClipCommand(&command, start_x, start_y, start_x + 63, start_y + 31);
+    
+    // Even producers end on a set fill, odd ones on a clear one //
+    
+    for (int i = 0; i <= TEST_COMMANDS_PER_PRODUCER / 10; i++)
+    {
+        command.inverted = ((i + producer) & 1) != 0;
+        
+        while (!I2C_OLED_Service_Submit(&command))
+            sched_yield();
+    }
+    
+    I2C_OLED_Atomic_FetchAdd(&producers_done, 1);
+    
+    return NULL;
+}
+
+static void Test_Clipping(void)
+{
+    printf("clipping: %d producers, each fill clipped to its own quadrant\n", TEST_PRODUCERS);
+    
+    I2C_OLED_Service_Initialize();
+    I2C_OLED_ClearBuffer();
+    
+    Test_RunThreads(Test_ClipProducer);
+    
+    int wrong = 0;
+    
+    for (int i = 0; i < I2C_OLED_BUFFER_SIZE; i++)
+    {
+        int column = i % 128;
+        int page = i / 128;
+        uint8_t expected = (((column / 64) + (page / 4) * 2) & 1) == 0 ? 0xFF : 0x00;
+        
+        if (I2C_OLED_buffer[i] != expected)
+            wrong++;
+    }
+    
+    TEST_EXPECT(wrong == 0, "%d buffer bytes drawn by another producer's fill", wrong);
+    TEST_EXPECT(I2C_OLED_clip.start_x == 0 && I2C_OLED_clip.end_x == 127, "clip left pushed after the last drain");
+}
+
+// Single thread: full queue, drop counter, bounded drain //
+
+static int resubmitted = 0;
+
+static void Test_ResubmitCallback(void *argument)
+{
+    (void)argument;
+    
+    resubmitted++;
+    I2C_OLED_Service_Callback(Test_ResubmitCallback, NULL);
+}
+
+static void Test_Bounds(void)
+{
+    printf("bounds: full queue and drain limit\n");
+    
+    I2C_OLED_Service_Initialize();
+    
+    int accepted = 0;
+    
+    for (int i = 0; i < I2C_OLED_SERVICE_QUEUE_SIZE + 5; i++)
+    {
+        if (I2C_OLED_Service_Clear())
+            accepted++;
+    }
+    
+    TEST_EXPECT(accepted == I2C_OLED_SERVICE_QUEUE_SIZE, "%d accepted, queue holds %d", accepted, I2C_OLED_SERVICE_QUEUE_SIZE);
+    TEST_EXPECT(I2C_OLED_Service_GetDropped() == 5, "%u dropped, expected 5", I2C_OLED_Service_GetDropped());
+    TEST_EXPECT(I2C_OLED_Service_Drain() == I2C_OLED_SERVICE_QUEUE_SIZE, "drain did not render the full queue");
+    TEST_EXPECT(I2C_OLED_Service_Drain() == 0, "queue not empty after drain");
+    
+    // A command that keeps submitting cannot hold the display task //
+    
+    I2C_OLED_Service_Callback(Test_ResubmitCallback, NULL);
+    
+    TEST_EXPECT(I2C_OLED_Service_Drain() == I2C_OLED_SERVICE_QUEUE_SIZE, "drain was not bounded");
+    TEST_EXPECT(resubmitted == I2C_OLED_SERVICE_QUEUE_SIZE, "%d callbacks ran", resubmitted);
+    
+    // Text longer than a command holds is cut, not overrun (ASan/TSan builds catch an overrun) //
+    
+    I2C_OLED_Service_Initialize();
+    
+    TEST_EXPECT(I2C_OLED_Service_PrintStrXY("a string longer than twelve", 0, 0, false), "text rejected");
+    TEST_EXPECT(!I2C_OLED_Service_PrintStrXY(NULL, 0, 0, false), "NULL text accepted");
+    TEST_EXPECT(!I2C_OLED_Service_Submit(NULL), "NULL command accepted");
+    TEST_EXPECT(I2C_OLED_Service_Drain() == 1, "text command not rendered");
+}
+
+int main(void)
+{
+    static I2C_HandleTypeDef i2c_handler;
+    
+    I2C_OLED_Initialize(&i2c_handler);
+    I2C_OLED_manual_update = false;
+    
+    Test_Bounds();
+    Test_Ordering();
+    Test_Drawing();
+    Test_Clipping();
+    
+    printf(failures == 0 ? "all service tests passed\n" : "%d failure(s)\n", failures);
+    
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,731 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/*
+    Trace analyzer: reads I2C_OLED_Trace_Dump() lines, decodes every
+    transfer into SSD1306 commands and GDDRAM writes, rebuilds the display
+    RAM and reports what the traffic costs on the wire.
+    
+    A frame is a burst of transfers, split where two timestamps are at
+    least the gap apart (-g, in timestamp units, ms with HAL_GetTick()).
+    Reported per frame and in total:
+        transfers, data bytes, wire bytes and wire time at 100 kHz, 400 kHz and 1 MHz
+        redundant       address commands that leave the RAM pointer where it was
+        zero-length     transfers without a byte after the control byte,
+                        or a data stream control byte with no data
+        unchanged       data bytes that rewrite GDDRAM with the value it holds
+        avoidable       wire bytes of the three above (2 per byte sent as a Co = 1 pair)
+    
+    Payload bytes past I2C_OLED_TRACE_PAYLOAD are not in the dump. Data
+    they carried moves the RAM pointer but leaves the bytes unknown ('?'
+    with -f), so build with a payload of 160 or more for a full picture.
+    
+    trace_analyze [file]            decode each transfer, then the summary (stdin without a file)
+    trace_analyze -q [file]         summary only
+    trace_analyze -f [file]         also print the rebuilt display after each frame
+    trace_analyze -g <gap> [file]   frame gap (default 2)
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_COLUMNS           128
+#define TRACE_PAGES             8
+
+#define TRACE_LINE_LENGTH       4096
+#define TRACE_MAX_PAYLOAD       1024
+
+// Slave address and control byte on top of the recorded length, 8 data bits + ACK per byte, START and STOP //
+#define TRACE_WIRE_OVERHEAD     2
+#define TRACE_BITS_PER_BYTE     9
+#define TRACE_BITS_PER_TRANSFER 2
+
+static const uint32_t trace_bitrates[] = { 100000, 400000, 1000000 };
+
+#define TRACE_BITRATES          (sizeof(trace_bitrates) / sizeof(trace_bitrates[0]))
+
+typedef struct
+{
+    uint32_t timestamp;
+    uint8_t control;
+    uint16_t length;
+    uint16_t traced;
+    uint8_t payload[TRACE_MAX_PAYLOAD];
+} Trace_Entry;
+
+typedef struct
+{
+    uint32_t transfers;
+    uint32_t data_bytes;
+    uint32_t wire_bytes;
+    uint64_t wire_bits;
+    uint32_t redundant;
+    uint32_t zero_length;
+    uint32_t unchanged;
+    uint32_t avoidable_bytes;
+} Trace_Counters;
+
+// Controller model //
+
+typedef enum
+{
+    TRACE_MODE_HORIZONTAL = 0,
+    TRACE_MODE_VERTICAL = 1,
+    TRACE_MODE_PAGE = 2,
+} Trace_Mode;
+
+static struct
+{
+    uint8_t ram[TRACE_PAGES][TRACE_COLUMNS];
+    bool known[TRACE_PAGES][TRACE_COLUMNS];
+    
+    // RAM pointer, -1 until a command sets it (column nibbles are collected until both are known) //
+    int16_t page;
+    int16_t column;
+    int8_t column_low, column_high;
+    
+    Trace_Mode mode;
+    uint8_t column_start, column_end;
+    uint8_t page_start, page_end;
+    
+    uint8_t start_line;
+    uint8_t rows;
+    
+    // Command being collected //
+    uint8_t opcode;
+    uint8_t arguments[8];
+    uint8_t argument_count;
+    uint8_t arguments_needed;
+    uint8_t command_wire_bytes;
+} oled;
+
+static Trace_Counters frame_counters;
+static Trace_Counters total_counters;
+
+static bool verbose = true;
+
+// Decoded text of the current transfer //
+static char decoded[TRACE_LINE_LENGTH];
+static size_t decoded_length;
+
+// Data run being decoded, printed as one item //
+static uint32_t data_run = 0;
+static uint32_t data_run_untraced = 0;
+static int16_t data_run_page, data_run_column;
+
+static void Trace_Print(const char *format, ...)
+{
+    if (!verbose || decoded_length >= sizeof(decoded) - 1)
+        return;
+    
+    va_list arguments;
+    va_start(arguments, format);
+    
+    int written = vsnprintf(decoded + decoded_length, sizeof(decoded) - decoded_length, format, arguments);
+    
+    va_end(arguments);
+    
+    if (written > 0)
+        decoded_length += written;
+    
+    if (decoded_length > sizeof(decoded) - 1)
+        decoded_length = sizeof(decoded) - 1;
+}
+
+static void Trace_Reset(void)
+{
+    memset(&oled, 0, sizeof(oled));
+    
+    oled.page = -1;
+    oled.column = -1;
+    oled.column_low = -1;
+    oled.column_high = -1;
+    oled.mode = TRACE_MODE_PAGE;
+    oled.column_end = TRACE_COLUMNS - 1;
+    oled.page_end = TRACE_PAGES - 1;
+    oled.rows = 64;
+}
+
+static void Trace_FlushDataRun(void)
+{
+    if (data_run == 0)
+        return;
+    
+    if (data_run_page < 0 || data_run_column < 0)
+        Trace_Print(", data %u bytes at unknown address", data_run);
+    else
+        Trace_Print(", data %u bytes at page %d column %d", data_run, data_run_page, data_run_column);
+    
+    if (data_run_untraced > 0)
+        Trace_Print(" (%u not traced)", data_run_untraced);
+    
+    data_run = 0;
+    data_run_untraced = 0;
+}
+
+static void Trace_AdvancePointer(void)
+{
+    if (oled.column < 0 || oled.page < 0)
+        return;
+    
+    // Page addressing wraps to column 0 of the same page //
+    
+    if (oled.mode == TRACE_MODE_PAGE)
+    {
+        oled.column = (oled.column + 1) % TRACE_COLUMNS;
+        return;
+    }
+    
+    if (oled.mode == TRACE_MODE_VERTICAL)
+    {
+        if (oled.page < oled.page_end)
+        {
+            oled.page++;
+            return;
+        }
+        
+        oled.page = oled.page_start;
+        oled.column = (oled.column < oled.column_end) ? oled.column + 1 : oled.column_start;
+        return;
+    }
+    
+    if (oled.column < oled.column_end)
+    {
+        oled.column++;
+        return;
+    }
+    
+    oled.column = oled.column_start;
+    oled.page = (oled.page < oled.page_end) ? oled.page + 1 : oled.page_start;
+}
+
+// traced is false for bytes past the dump's payload //
+
+static void Trace_DataByte(uint8_t value, bool traced, uint8_t wire_bytes)
+{
+    if (data_run == 0)
+    {
+        data_run_page = oled.page;
+        data_run_column = oled.column;
+    }
+    
+    data_run++;
+    frame_counters.data_bytes++;
+    
+    if (!traced)
+        data_run_untraced++;
+    
+    if (oled.page >= 0 && oled.column >= 0)
+    {
+        bool *known = &oled.known[oled.page][oled.column];
+        uint8_t *ram = &oled.ram[oled.page][oled.column];
+        
+        if (traced && *known && *ram == value)
+        {
+            frame_counters.unchanged++;
+            frame_counters.avoidable_bytes += wire_bytes;
+        }
+        
+        *ram = value;
+        *known = traced;
+    }
+    
+    Trace_AdvancePointer();
+}
+
+// Commands //
+
+static uint8_t Trace_ArgumentsNeeded(uint8_t opcode)
+{
+    switch (opcode)
+    {
+        case 0x20:
+        case 0x81:
+        case 0x8D:
+        case 0xA8:
+        case 0xD3:
+        case 0xD5:
+        case 0xD9:
+        case 0xDA:
+        case 0xDB:
+            return 1;
+        case 0x21:
+        case 0x22:
+        case 0xA3:
+            return 2;
+        case 0x29:
+        case 0x2A:
+            return 5;
+        case 0x26:
+        case 0x27:
+            return 6;
+        case 0x2C:
+        case 0x2D:
+            return 7;
+        default:
+            return 0;
+    }
+}
+
+static void Trace_Redundant(const char *what)
+{
+    frame_counters.redundant++;
+    frame_counters.avoidable_bytes += oled.command_wire_bytes;
+    
+    Trace_Print(" [redundant %s]", what);
+}
+
+static void Trace_ExecuteCommand(void)
+{
+    uint8_t opcode = oled.opcode;
+    const uint8_t *arguments = oled.arguments;
+    
+    if (opcode >= 0xB0 && opcode <= 0xB7)
+    {
+        Trace_Print(", page %d", opcode - 0xB0);
+        
+        if (oled.page == opcode - 0xB0)
+            Trace_Redundant("page");
+        
+        oled.page = opcode - 0xB0;
+    }
+    else if (opcode <= 0x1F)
+    {
+        bool is_high = opcode >= 0x10;
+        uint8_t nibble = is_high ? (opcode & 0x07) : (opcode & 0x0F);
+        
+        Trace_Print(", column %s %X", is_high ? "high" : "low", nibble);
+        
+        if (oled.column >= 0)
+        {
+            if ((is_high ? (oled.column >> 4) : (oled.column & 0x0F)) == nibble)
+                Trace_Redundant("column");
+            
+            oled.column = is_high ? ((oled.column & 0x0F) | (nibble << 4)) : ((oled.column & 0x70) | nibble);
+        }
+        else
+        {
+            if (is_high)
+                oled.column_high = nibble;
+            else
+                oled.column_low = nibble;
+            
+            if (oled.column_low >= 0 && oled.column_high >= 0)
+                oled.column = (oled.column_high << 4) | oled.column_low;
+        }
+    }
+    else if (opcode == 0x20)
+    {
+        static const char *mode_names[] = { "horizontal", "vertical", "page", "invalid" };
+        
+        Trace_Print(", addressing mode %02X (%s)", arguments[0], mode_names[arguments[0] & 0x03]);
+        
+        oled.mode = ((arguments[0] & 0x03) == 0x03) ? TRACE_MODE_PAGE : (Trace_Mode)(arguments[0] & 0x03);
+    }
+    else if (opcode == 0x21 || opcode == 0x22)
+    {
+        bool is_column = opcode == 0x21;
+        
+        uint8_t start = arguments[0] & (is_column ? 0x7F : 0x07);
+        uint8_t end = arguments[1] & (is_column ? 0x7F : 0x07);
+        
+        Trace_Print(", %s window %d-%d", is_column ? "column" : "page", start, end);
+        
+        uint8_t *window_start = is_column ? &oled.column_start : &oled.page_start;
+        uint8_t *window_end = is_column ? &oled.column_end : &oled.page_end;
+        int16_t *pointer = is_column ? &oled.column : &oled.page;
+        
+        if (*window_start == start && *window_end == end && *pointer == start)
+            Trace_Redundant(is_column ? "column window" : "page window");
+        
+        *window_start = start;
+        *window_end = end;
+        *pointer = start;
+    }
+    else if (opcode >= 0x40 && opcode <= 0x7F)
+    {
+        Trace_Print(", start line %d", opcode - 0x40);
+        
+        oled.start_line = opcode - 0x40;
+    }
+    else if (opcode == 0xA8)
+    {
+        Trace_Print(", multiplex %d", (arguments[0] & 0x3F) + 1);
+        
+        oled.rows = (arguments[0] & 0x3F) + 1;
+    }
+    else if (opcode == 0xAE || opcode == 0xAF)
+    {
+        Trace_Print(", display %s", opcode == 0xAF ? "on" : "off");
+    }
+    else if (opcode == 0x81)
+    {
+        Trace_Print(", contrast %02X", arguments[0]);
+    }
+    else if (opcode == 0x2C || opcode == 0x2D)
+    {
+        Trace_Print(", scroll %s one column, pages %d-%d, columns %d-%d", opcode == 0x2D ? "left" : "right", arguments[1] & 0x07, arguments[3] & 0x07, arguments[5], arguments[6]);
+    }
+    else
+    {
+        Trace_Print(", %02X", opcode);
+        
+        for (int i = 0; i < oled.argument_count; i++)
+            Trace_Print(" %02X", arguments[i]);
+    }
+}
+
+static void Trace_CommandByte(uint8_t value, uint8_t wire_bytes)
+{
+    if (oled.arguments_needed == 0)
+    {
+        oled.opcode = value;
+        oled.argument_count = 0;
+        oled.arguments_needed = Trace_ArgumentsNeeded(value);
+        oled.command_wire_bytes = 0;
+    }
+    else
+    {
+        oled.arguments[oled.argument_count++] = value;
+        oled.arguments_needed--;
+    }
+    
+    oled.command_wire_bytes += wire_bytes;
+    
+    if (oled.arguments_needed == 0)
+        Trace_ExecuteCommand();
+}
+
+// Transfers //
+
+/*
+    The transfer is the control byte followed by length bytes, of which
+    the first traced ones are known. Co = 1 control bytes carry a single
+    command or data byte and another control byte follows, Co = 0 streams
+    the rest. Packet entries record their first 0x80 as the control byte.
+*/
+static void Trace_DecodeTransfer(const Trace_Entry *entry)
+{
+    uint16_t total = entry->length + 1;
+    uint16_t known = entry->traced + 1;
+    
+    uint16_t position = 0;
+    
+    while (position < total)
+    {
+        if (position >= known)
+        {
+            Trace_Print(", %u bytes not traced", total - position);
+            return;
+        }
+        
+        uint8_t control = (position == 0) ? entry->control : entry->payload[position - 1];
+        
+        position++;
+        
+        bool is_data = (control & 0x40) != 0;
+        
+        if ((control & 0x80) == 0)
+        {
+            // Stream to the end //
+            
+            if (position == total)
+            {
+                Trace_FlushDataRun();
+                
+                frame_counters.zero_length++;
+                frame_counters.avoidable_bytes++;
+                
+                Trace_Print(", empty %s stream [zero-length]", is_data ? "data" : "command");
+            }
+            
+            if (!is_data)
+                Trace_FlushDataRun();
+            
+            for (; position < total; position++)
+            {
+                bool traced = position < known;
+                uint8_t value = traced ? entry->payload[position - 1] : 0x00;
+                
+                if (is_data)
+                {
+                    Trace_DataByte(value, traced, 1);
+                }
+                else if (traced)
+                {
+                    Trace_CommandByte(value, 1);
+                }
+                else
+                {
+                    Trace_Print(", %u command bytes not traced", total - position);
+                    return;
+                }
+            }
+            
+            return;
+        }
+        
+        if (position >= total)
+            return;
+        
+        if (position >= known)
+            continue;
+        
+        uint8_t value = entry->payload[position - 1];
+        
+        position++;
+        
+        if (is_data)
+        {
+            Trace_DataByte(value, true, 2);
+        }
+        else
+        {
+            Trace_FlushDataRun();
+            Trace_CommandByte(value, 2);
+        }
+    }
+}
+
+static bool Trace_ParseLine(const char *line, Trace_Entry *entry)
+{
+    unsigned int timestamp, control, length;
+    int consumed;
+    
+    if (sscanf(line, "%8x %2x %4x%n", &timestamp, &control, &length, &consumed) != 3)
+        return false;
+    
+    entry->timestamp = timestamp;
+    entry->control = control;
+    entry->length = length;
+    entry->traced = 0;
+    
+    const char *ptr_line = line + consumed;
+    unsigned int value;
+    int advance;
+    
+    while (entry->traced < entry->length && entry->traced < TRACE_MAX_PAYLOAD && sscanf(ptr_line, " %2x%n", &value, &advance) == 1)
+    {
+        entry->payload[entry->traced++] = value;
+        ptr_line += advance;
+    }
+    
+    return true;
+}
+
+// Reporting //
+
+static void Trace_Accumulate(Trace_Counters *counters, const Trace_Counters *add)
+{
+    counters->transfers += add->transfers;
+    counters->data_bytes += add->data_bytes;
+    counters->wire_bytes += add->wire_bytes;
+    counters->wire_bits += add->wire_bits;
+    counters->redundant += add->redundant;
+    counters->zero_length += add->zero_length;
+    counters->unchanged += add->unchanged;
+    counters->avoidable_bytes += add->avoidable_bytes;
+}
+
+static void Trace_PrintCounters(FILE *output, const char *name, uint32_t start, const Trace_Counters *counters)
+{
+    fprintf(output, "%-7s %10u %9u %10u %10u", name, start, counters->transfers, counters->data_bytes, counters->wire_bytes);
+    
+    for (size_t i = 0; i < TRACE_BITRATES; i++)
+        fprintf(output, " %8.2f", (counters->wire_bits * 1000.0) / trace_bitrates[i]);
+    
+    fprintf(output, " %9u %11u %9u %9u\n", counters->redundant, counters->zero_length, counters->unchanged, counters->avoidable_bytes);
+}
+
+static void Trace_PrintHeader(void)
+{
+    printf("%-7s %10s %9s %10s %10s", "frame", "start", "transfers", "data bytes", "wire bytes");
+    
+    for (size_t i = 0; i < TRACE_BITRATES; i++)
+        printf(" %5ukHz", trace_bitrates[i] / 1000);
+    
+    printf(" %9s %11s %9s %9s\n", "redundant", "zero-length", "unchanged", "avoidable");
+}
+
+// Rows as the panel shows them from the start line, '#' lit, '?' not known //
+
+static void Trace_PrintDisplay(void)
+{
+    for (int row = 0; row < oled.rows; row++)
+    {
+        int ram_row = (row + oled.start_line) % (TRACE_PAGES * 8);
+        
+        char line[TRACE_COLUMNS + 1];
+        
+        for (int column = 0; column < TRACE_COLUMNS; column++)
+        {
+            if (!oled.known[ram_row / 8][column])
+                line[column] = '?';
+            else
+                line[column] = (oled.ram[ram_row / 8][column] >> (ram_row % 8)) & 0x01 ? '#' : '.';
+        }
+        
+        line[TRACE_COLUMNS] = '\0';
+        
+        printf("%s\n", line);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bool print_display = false;
+    uint32_t gap = 2;
+    const char *path = NULL;
+    
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-q") == 0)
+            verbose = false;
+        else if (strcmp(argv[i], "-f") == 0)
+            print_display = true;
+        else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc)
+            gap = strtoul(argv[++i], NULL, 0);
+        else if (argv[i][0] != '-' && path == NULL)
+            path = argv[i];
+        else
+        {
+            fprintf(stderr, "usage: %s [-q] [-f] [-g gap] [dump file]\n", argv[0]);
+            return 2;
+        }
+    }
+    
+    FILE *input = (path != NULL) ? fopen(path, "r") : stdin;
+    
+    if (input == NULL)
+    {
+        perror(path);
+        return 1;
+    }
+    
+    Trace_Reset();
+    
+    static char line[TRACE_LINE_LENGTH];
+    static Trace_Entry entry;
+    
+    // Frame summaries are printed after the decoded listing //
+    
+    static char summary[1 << 16];
+    FILE *frames = fmemopen(summary, sizeof(summary), "w");
+    
+    uint32_t frame = 0;
+    uint32_t frame_start = 0;
+    uint32_t previous_timestamp = 0;
+    uint32_t skipped = 0;
+    uint32_t index = 0;
+    
+    bool have_frame = false;
+    
+    for (;;)
+    {
+        bool have_line = fgets(line, sizeof(line), input) != NULL;
+        bool parsed = have_line && Trace_ParseLine(line, &entry);
+        
+        if (have_line && !parsed)
+        {
+            skipped++;
+            continue;
+        }
+        
+        // Frame boundary: a gap in time or the end of the dump //
+        
+        if (have_frame && (!have_line || entry.timestamp - previous_timestamp >= gap))
+        {
+            char name[16];
+            snprintf(name, sizeof(name), "%u", frame);
+            
+            Trace_PrintCounters(frames, name, frame_start, &frame_counters);
+            
+            if (print_display)
+            {
+                printf("-- frame %u, start line %d --\n", frame, oled.start_line);
+                Trace_PrintDisplay();
+            }
+            
+            Trace_Accumulate(&total_counters, &frame_counters);
+            memset(&frame_counters, 0, sizeof(frame_counters));
+            
+            frame++;
+            have_frame = false;
+        }
+        
+        if (!have_line)
+            break;
+        
+        if (!have_frame)
+        {
+            frame_start = entry.timestamp;
+            have_frame = true;
+        }
+        
+        previous_timestamp = entry.timestamp;
+        
+        uint32_t wire_bytes = entry.length + TRACE_WIRE_OVERHEAD;
+        
+        frame_counters.transfers++;
+        frame_counters.wire_bytes += wire_bytes;
+        frame_counters.wire_bits += ((uint64_t)wire_bytes * TRACE_BITS_PER_BYTE) + TRACE_BITS_PER_TRANSFER;
+        
+        decoded_length = 0;
+        decoded[0] = '\0';
+        
+        if (entry.length == 0)
+        {
+            frame_counters.zero_length++;
+            frame_counters.avoidable_bytes += TRACE_WIRE_OVERHEAD;
+            
+            Trace_Print(", nothing after the control byte [zero-length]");
+        }
+        else
+        {
+            Trace_DecodeTransfer(&entry);
+        }
+        
+        Trace_FlushDataRun();
+        
+        if (verbose)
+            printf("%5u %08X %02X %4u%s\n", index, entry.timestamp, entry.control, entry.length, decoded_length > 1 ? decoded + 1 : "");
+        
+        index++;
+    }
+    
+    if (input != stdin)
+        fclose(input);
+    
+    fclose(frames);
+    
+    if (verbose || print_display)
+        printf("\n");
+    
+    printf("wire time in ms, %u transfers in %u frame(s)", index, frame);
+    
+    if (skipped > 0)
+        printf(", %u line(s) skipped", skipped);
+    
+    printf("\n");
+    
+    Trace_PrintHeader();
+    fputs(summary, stdout);
+    Trace_PrintCounters(stdout, "total", 0, &total_counters);
+    
+    if (total_counters.wire_bytes > 0)
+    {
+        printf
+        (
+            "\n%u of %u wire bytes (%.1f%%) are avoidable, unchanged rewrites are %.1f%% of the data bytes\n",
+            total_counters.avoidable_bytes,
+            total_counters.wire_bytes,
+            (total_counters.avoidable_bytes * 100.0) / total_counters.wire_bytes,
+            total_counters.data_bytes > 0 ? (total_counters.unchanged * 100.0) / total_counters.data_bytes : 0.0
+        );
+    }
+    
+    return 0;
+}
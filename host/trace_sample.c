@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/*
+    Trace sample: the driver built with I2C_OLED_TRACE against the null
+    HAL, a few typical frames, then I2C_OLED_Trace_Dump() to stdout. The
+    Makefile pipes it into trace_analyze.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "I2C_OLED.h"
+#include "I2C_OLED_Trace.h"
+#include "null_hal.h"
+
+static void Sample_WriteLine(const char *line)
+{
+    fputs(line, stdout);
+}
+
+int main(void)
+{
+    static I2C_HandleTypeDef i2c_handler;
+    
+    I2C_OLED_Initialize(&i2c_handler);
+    I2C_OLED_manual_update = true;
+    
+    // Frame 0: full update of a new screen //
+    
+    HAL_Delay(40);
+    
+    I2C_OLED_ClearBuffer();
+    I2C_OLED_PrintStrXY("trace sample", 0, 0, false);
+    I2C_OLED_DrawRect(0, 16, 127, 63, false);
+    I2C_OLED_Update();
+    
+    // Frame 1: only the counter changed, but the whole screen is sent again //
+    
+    HAL_Delay(40);
+    
+    I2C_OLED_PrintStrXY("1", 60, 32, false);
+    I2C_OLED_Update();
+    
+    // Frame 2: the same change through the dirty area, addressed page by page //
+    
+    HAL_Delay(40);
+    
+    I2C_OLED_FillRect(60, 32, 65, 39, true);
+    I2C_OLED_PrintStrXY("2", 60, 32, false);
+    I2C_OLED_UpdatePartially(60, 65, 4, 4);
+    
+    // Frame 3: a Co-bit packet with the same address twice and an empty data stream //
+    
+    HAL_Delay(40);
+    
+    static uint8_t packet_buffer[32];
+    I2C_OLED_Packet packet;
+    
+    I2C_OLED_Packet_Begin(&packet, packet_buffer, sizeof(packet_buffer));
+    I2C_OLED_Packet_AddColumnPage(&packet, 60, 4);
+    I2C_OLED_Packet_AddColumnPage(&packet, 60, 4);
+    I2C_OLED_Packet_AddData(&packet, I2C_OLED_buffer + (4 * I2C_OLED_COLUMNS) + 60, 2);
+    I2C_OLED_Packet_AddDataStream(&packet, I2C_OLED_buffer, 0);
+    I2C_OLED_Packet_Send(&packet);
+    
+    I2C_OLED_Trace_Dump(Sample_WriteLine);
+    
+    return 0;
+}